@@ -139,6 +139,7 @@ python $EMCC $CHATTY \
 	$VEROVIO_ROOT/src/staff.cpp \
 	$VEROVIO_ROOT/src/style.cpp \
 	$VEROVIO_ROOT/src/svgdevicecontext.cpp \
+	$VEROVIO_ROOT/src/streamingsvgdevicecontext.cpp \
 	$VEROVIO_ROOT/src/syl.cpp \
 	$VEROVIO_ROOT/src/system.cpp \
 	$VEROVIO_ROOT/src/textdirective.cpp \
@@ -180,7 +181,8 @@ python $EMCC $CHATTY \
 		'_vrvToolkit_renderPage',\
 		'_vrvToolkit_setOptions',\
 		'_vrvToolkit_edit',\
-		'_vrvToolkit_getElementAttr']" \
+		'_vrvToolkit_getElementAttr',\
+		'_vrvToolkit_getSystemBreakWidths']" \
 	-o build/verovio.js
 
 if [ $? -eq 0 ]; then 
@@ -32,11 +32,12 @@ extern "C" {
 		// for mei ids
         if (!initialized) {
             std::srand(std::time(0));
+            Object::SeedUuidGenerator( std::rand() );
             initialized = true;
         }
 		
 		// set the resource path in the js blob
-		Resources::SetPath("/data");
+		Resources::SetDefaultPath("/data");
 		
 		return new Toolkit();
 	}
@@ -109,4 +110,17 @@ extern "C" {
         tk->SetCString(tk->GetElementAttr( xmlId ));
         return tk->GetCString();
     }
+    
+    const char* vrvToolkit_getSystemBreakWidths(Toolkit *tk, int min_width, int max_width) {
+        // Returned as a JSON array of numbers
+        std::vector<int> widths = tk->GetSystemBreakWidths( min_width, max_width );
+        std::stringstream json;
+        json << "[";
+        for (int i = 0; i < (int)widths.size(); i++) {
+            json << ((i > 0) ? "," : "") << widths.at(i);
+        }
+        json << "]";
+        tk->SetCString(json.str());
+        return tk->GetCString();
+    }
 }
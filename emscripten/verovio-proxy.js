@@ -49,6 +49,9 @@ verovio.vrvToolkit.edit = Module.cwrap('vrvToolkit_edit', 'number', ['number', '
 // char *getElementAttr(Toolkit *ic, const char *xmlId )
 verovio.vrvToolkit.getElementAttr = Module.cwrap('vrvToolkit_getElementAttr', 'string', ['number', 'string']);
 
+// char *getSystemBreakWidths(Toolkit *ic, int minWidth, int maxWidth )
+verovio.vrvToolkit.getSystemBreakWidths = Module.cwrap('vrvToolkit_getSystemBreakWidths', 'string', ['number', 'number', 'number']);
+
 // A pointer to the object - only one instance can be created for now
 verovio.ptr = 0;
 
@@ -119,4 +122,8 @@ verovio.toolkit.prototype.getElementAttr = function (xmlId) {
   	return verovio.vrvToolkit.getElementAttr(this.ptr, xmlId);
 };
 
+verovio.toolkit.prototype.getSystemBreakWidths = function (minWidth, maxWidth) {
+  	return verovio.vrvToolkit.getSystemBreakWidths(this.ptr, minWidth, maxWidth);
+};
+
 /***************************************************************************************************************************/
@@ -13,12 +13,15 @@
 
 namespace vrv {
 
+class Alignment;
 class GraceAligner;
 class MeasureAligner;
 class Note;
 class StaffAlignment;
 class SystemAligner;
 
+typedef std::vector<Alignment*> ArrayOfAlignments;
+
 /**
  * Alignment types for aligning types together.
  * For example, we align notes and rests (default) together, clefs separately, etc.
@@ -54,6 +57,9 @@ enum AlignmentType {
 /**
  * This class aligns the content of a system
  * It contains a vector of StaffAlignment
+ * The aligners and the alignments are used only for the layout and are not in the uuid index
+ * of the document. The alignments of a measure are re-used from one layout to the other
+ * (see MeasureAligner::Reset).
  */
 class SystemAligner: public Object
 {
@@ -167,15 +173,22 @@ private:
 
 /** 
  * This class stores an alignement position elements will point to
+ * It is not an Object: it has no uuid and no children and is owned by its MeasureAligner,
+ * which redirects the functors to it.
  */
-class Alignment: public Object
+class Alignment
 {
 public:
     // constructors and destructors
     Alignment( );
     Alignment( double time, AlignmentType type = ALIGNMENT_DEFAULT );
-    virtual ~Alignment();
-    virtual ClassId Is() { return ALIGNMENT; }
+    ~Alignment();
+    
+    /**
+     * Reset all the values of the alignment for re-using it at the time and type position.
+     * The GraceAligner, if any, is deleted.
+     */
+    void ResetAlignment( double time, AlignmentType type );
     
     void SetXRel( int x_rel );
     int GetXRel() { return m_xRel; };
@@ -202,6 +215,12 @@ public:
     AlignmentType GetType() { return m_type; };
     ///@}
     
+    /**
+     * Return true if the alignment is before the time and type position.
+     * Alignments are ordered by time and then by type (see MeasureAligner::GetAlignmentAtTime).
+     */
+    bool IsBefore( double time, AlignmentType type );
+    
     /**
      * Returns the GraceAligner for the Alignment.
      * Create it if necessary.
@@ -215,30 +234,31 @@ public:
     
     /**
      * Correct the X alignment of grace notes once the content of a system has been aligned and laid out.
-     * Special case that redirects the functor to the GraceAligner.
+     * Called by MeasureAligner::IntegrateBoundingBoxGraceXShift.
      */
-    virtual int IntegrateBoundingBoxGraceXShift( ArrayPtrVoid *params );
+    void IntegrateBoundingBoxGraceXShift( );
     
     /**
      * Correct the X alignment once the content of a system has been aligned and laid out.
-     * Special case of functor redirected from Measure.
+     * Called by MeasureAligner::IntegrateBoundingBoxXShift with the parameters of the functor.
      */
-    virtual int IntegrateBoundingBoxXShift( ArrayPtrVoid *params );
+    void IntegrateBoundingBoxXShift( ArrayPtrVoid *params, MeasureAligner *aligner );
     
 
-    virtual int HorizontalSpaceForDuration(double intervalTime, int maxActualDur, double spacingLinear, double spacingNonLinear);
+    int HorizontalSpaceForDuration(double intervalTime, int maxActualDur, double spacingLinear, double spacingNonLinear);
 
     /**
      * Set the position of the Alignment.
      * Looks at the time different with the previous Alignment.
+     * Called by MeasureAligner::SetAlignmentXPos with the parameters of the functor.
      */
-    virtual int SetAlignmentXPos( ArrayPtrVoid *params );
+    void SetAlignmentXPos( ArrayPtrVoid *params );
     
     /**
      * Justify the X positions
-     * Special case of functor redirected from Measure.
+     * Called by MeasureAligner::JustifyX with the parameters of the functor.
      */
-    virtual int JustifyX( ArrayPtrVoid *params );
+    void JustifyX( ArrayPtrVoid *params );
     
 private:
     
@@ -291,7 +311,7 @@ private:
 
 /**
  * This class aligns the content of a measure
- * It contains a vector of Alignment
+ * It contains a vector of Alignment (not as children since Alignment is not an Object)
  */
 class MeasureAligner: public Object
 {
@@ -301,13 +321,23 @@ public:
     virtual ~MeasureAligner();
     virtual ClassId Is() { return MEASURE_ALIGNER; }
     
-    int GetAlignmentCount() const { return (int)m_children.size(); };
+    int GetAlignmentCount() const { return (int)m_alignments.size(); };
+    
+    /**
+     * Get the Alignment at index idx.
+     */
+    Alignment *GetAlignmentAt( int idx ) { return m_alignments.at(idx); };
     
     /**
      * Reset the aligner (clear the content) and creates the start (left) and end (right) alignement
      */
     virtual void Reset();
     
+    /**
+     * Get the Alignment for the time and type, creating it if necessary.
+     * The Alignment objects are kept ordered by time and type, which makes the lookup logarithmic.
+     * With hasEndAlignment, the right Alignment always stays at the end.
+     */
     Alignment* GetAlignmentAtTime( double time, AlignmentType type, bool hasEndAlignment = true );
     
     /**
@@ -339,9 +369,15 @@ public:
      */
     Alignment *GetRightAlignment( ) { return m_rightAlignment; };
     
+    /**
+     * Correct the X alignment of grace notes once the content of a system has been aligned and laid out.
+     * Special case of functor redirected from Measure. Calls it on each Alignment.
+     */
+    virtual int IntegrateBoundingBoxGraceXShift( ArrayPtrVoid *params );
+    
     /**
      * Correct the X alignment once the the content of a system has been aligned and laid out.
-     * Special case of functor redirected from Measure.
+     * Special case of functor redirected from Measure. Calls it on each Alignment.
      */
     virtual int IntegrateBoundingBoxXShift( ArrayPtrVoid *params );
     
@@ -349,21 +385,47 @@ public:
      * Set the position of the Alignment.
      * Looks at the time different with the previous Alignment.
      * For each MeasureAlignment, we need to reset the previous time position.
+     * Calls it on each Alignment.
      */
     virtual int SetAlignmentXPos( ArrayPtrVoid *params );
     
     /**
      * Justify the X positions
-     * Special case of functor redirected from Measure.
+     * Special case of functor redirected from Measure. Calls it on each Alignment.
+     * The X positions before the justification are kept (see MeasureAligner::ResetJustification).
      */
     virtual int JustifyX( ArrayPtrVoid *params );
     
+    /**
+     * Restore the X positions of the Alignment objects as they were before the justification.
+     * This is used when the measure is not laid out again but its system has to be justified again.
+     * Nothing is done if the measure was not justified since it was aligned.
+     */
+    void ResetJustification( );
+    
+    /**
+     * Return the X position of the right Alignment before the justification
+     */
+    int GetNonJustifiedRightXRel( );
+    
 private:
     void AddAlignment( Alignment *alignment, int idx = -1 );
     
+    /**
+     * Return an Alignment for the time and type.
+     * An Alignment released by the previous Reset() is re-used when available.
+     */
+    Alignment *NewAlignment( double time, AlignmentType type );
+    
 public:
     
 private:
+    /**
+     * The Alignment objects ordered by time and type.
+     * The MeasureAligner owns them.
+     */
+    ArrayOfAlignments m_alignments;
+    
     /**
      * A pointer to the left Alignment object kept for the measure start position
      */
@@ -378,6 +440,19 @@ private:
      * Store measure's non-justifiable margin used by the scoreDef attributes.
      */
     int m_nonJustifiableLeftMargin;
+    
+    /**
+     * The Alignment objects released by Reset() and kept for being re-used.
+     * Because the layout is redone with the same content most of the time, this avoids
+     * deleting and re-creating all of them. The MeasureAligner owns them.
+     */
+    ArrayOfAlignments m_spareAlignments;
+    
+    /**
+     * The X positions of the Alignment objects before the justification.
+     * It is empty if the measure was not justified since it was aligned.
+     */
+    std::vector<int> m_nonJustifiedXRels;
 };
     
 //----------------------------------------------------------------------------
@@ -20,6 +20,7 @@
 namespace vrv {
 
 class DocObject;
+class Resources;
 class View;
 
 // ---------------------------------------------------------------------------
@@ -44,7 +45,7 @@ public:
      * @name Constructors, destructors, and other standard methods
      */
     ///@{
-    DeviceContext () { m_drawingBoundingBoxes = false; m_isDeactivated = false; };
+    DeviceContext () { m_drawingBoundingBoxes = false; m_isDeactivated = false; m_resources = NULL; };
     virtual ~DeviceContext() {};
     ///@}
     
@@ -65,6 +66,7 @@ public:
     virtual void SetTextForeground( int colour ) = 0;
     virtual void SetTextBackground( int colour ) = 0;
     virtual void SetLogicalOrigin( int x, int y ) = 0;
+    virtual void SetUserScale( double xScale, double yScale ) = 0;
     ///}
 
     /**
@@ -170,6 +172,14 @@ public:
      */
     void VrvTextFont() { m_vrvTextFont = true; };
     
+    /**
+     * @name Setter and getter for the resources with the fonts of the document drawn (see View::DrawCurrentPage)
+     */
+    ///@{
+    void SetResources( const Resources *resources ) { m_resources = resources; };
+    const Resources *GetResources( ) { return m_resources; };
+    ///@}
+    
 protected:
     
     bool m_drawingBoundingBoxes;
@@ -187,6 +197,9 @@ protected:
     /** flag for indicating if the graphic is deactivated */
     bool m_isDeactivated;
     
+    /** The resources of the document drawn, which the glyphs are taken from */
+    const Resources *m_resources;
+    
 };
     
 } // namespace vrv
@@ -12,17 +12,23 @@
 #include "devicecontextbase.h"
 #include "scoredef.h"
 #include "style.h"
+#include "vrv.h"
 
 namespace vrv {
 
 class FontInfo;
 class Page;
+class System;
+struct PrepareByLayerJob;
     
 enum DocType {
     Raw = 0,
     Rendering,
     Transcription
 };
+    
+/** The number of measures of the first step of a progressive cast off (see Doc::ContinueCastOff) */
+#define CASTOFF_STEP_MEASURES 16
 
 
 //----------------------------------------------------------------------------
@@ -69,6 +75,12 @@ public:
 	*/
 	int GetPageCount( );
     
+    /**
+     * Get the resources (path and fonts) used for the document.
+     * They are kept by Reset, so they stay the same when another file is loaded.
+     */
+    Resources *GetResources( ) { return &m_resources; };
+    
     /**
      * @name Get the height or width for a glyph taking into account the staff and grace sizes  
      */
@@ -157,7 +169,7 @@ public:
      * It should be disabled (so we get "even" note spacing) for mensural notation.
      */
     ///@{
-    void SetEvenSpacing( bool drawingEvenSpacing ) { m_drawingEvenSpacing = drawingEvenSpacing; };
+    void SetEvenSpacing( bool drawingEvenSpacing ) { m_drawingEvenSpacing = drawingEvenSpacing; ResetCastOffLayout(); };
     bool GetEvenSpacing( ) { return m_drawingEvenSpacing; };
     ///@}
     
@@ -165,11 +177,44 @@ public:
      * @name Setter and getter for linear and non-linear spacing parameters
      */
     ///@{
-    void SetSpacingLinear( double drawingSpacingLinear ) { m_drawingSpacingLinear = drawingSpacingLinear; };
+    void SetSpacingLinear( double drawingSpacingLinear ) { m_drawingSpacingLinear = drawingSpacingLinear; ResetCastOffLayout(); };
     double GetSpacingLinear( ) { return m_drawingSpacingLinear; };
-    void SetSpacingNonLinear( double drawingSpacingNonLinear ) { m_drawingSpacingNonLinear = drawingSpacingNonLinear; };
+    void SetSpacingNonLinear( double drawingSpacingNonLinear ) { m_drawingSpacingNonLinear = drawingSpacingNonLinear; ResetCastOffLayout(); };
     double GetSpacingNonLinear( ) { return m_drawingSpacingNonLinear; };
     ///@}
+    
+    /*
+     * @name Setter and getter for the number of threads used in PrepareDrawing.
+     * With more than one thread, the staves are processed concurrently by Object::PrepareByLayer.
+     * It is 1 by default.
+     */
+    ///@{
+    void SetPrepareDrawingThreads( int prepareDrawingThreads ) { m_prepareDrawingThreads = prepareDrawingThreads; };
+    int GetPrepareDrawingThreads( ) { return m_prepareDrawingThreads; };
+    ///@}
+    
+    /**
+     * @name Setter and getter for the seed of the uuids generated for the objects of the document.
+     * The sequence is restarted when the document is reset, so loading the same data with the same
+     * seed generates the same uuids. The seed is taken from std::rand() by default.
+     */
+    ///@{
+    void SetUuidSeed( unsigned int seed ) { m_uuidGenerator.Seed( seed ); m_staffUuidGenerators.clear(); };
+    unsigned int GetUuidSeed( ) { return m_uuidGenerator.GetSeed(); };
+    ///@}
+    
+    /**
+     * Return the UuidGenerator of the document.
+     * It is set as the current one of the thread by the importers and by the methods of the
+     * document creating objects (see UuidGeneratorScope).
+     */
+    UuidGenerator *GetUuidGenerator( ) { return &m_uuidGenerator; };
+    
+    /**
+     * Return the ObjectArena of the document.
+     * It is the current arena when importing (see FileInputStream) and in CastOff.
+     */
+    ObjectArena *GetObjectArena( ) { return &m_objectArena; };
 
     /**
      * Set the initial scoreDef of each page.
@@ -189,8 +234,48 @@ public:
     /**
      * Casts off the entire document.
      * Starting from a single system, create and fill pages and systems.
+     * The horizontal layout of the single system is done only the first time and then kept
+     * (see Measure::m_castOffXRel), since it does not depend on the page size.
+     * When progressive, only the first page is cast off and the rest of the single system is
+     * kept aside (see ContinueCastOff).
+     */
+    void CastOff( bool progressive = false );
+    
+    /**
+     * Continue a progressive cast off until the page (0-based) is cast off, or until the end if -1.
+     * The measures are laid out and cast off in steps that grow with the pages needed. Since the
+     * last page of a step can still receive systems, it is cast off again with the next step and
+     * the page count includes it as long as the cast off is not complete.
+     */
+    void ContinueCastOff( int pageIdx = -1 );
+    
+    /**
+     * @name Check if the cast off is complete, and get an estimate of the page count when it is not.
+     * The estimate is based on the number of measures per page cast off so far.
+     */
+    ///@{
+    bool IsCastOffComplete( ) { return ( m_castOffContentSystem == NULL ); };
+    int GetEstimatedPageCount( );
+    ///@}
+    
+    /**
+     * @name Reset the horizontal layout of the single system kept by CastOff, or check if it is kept.
+     * It needs to be reset when the content of the document or the horizontal spacing changes.
+     */
+    ///@{
+    void ResetCastOffLayout( ) { m_castOffLayoutDone = false; };
+    bool HasCastOffLayout( ) { return ( m_castOffLayoutDone && !m_castOffContentSystem ); };
+    ///@}
+    
+    /**
+     * Compute the system breaks that CastOff would give for a page width (in pixels) without casting off
+     * the document again. The breaks are computed from the horizontal layout kept by the last CastOff
+     * (see HasCastOffLayout), with the margins of the document.
+     * Fill breaks with the indexes (0-based, in the whole document) of the measures starting a new system.
+     * Return the smallest page width larger than the one given for which the breaks change, or
+     * VRV_UNSET if they do not change anymore.
      */
-    void CastOff( );
+    int GetCastOffSystemBreaks( int pageWidth, std::vector<int> *breaks );
     
     /**
      * Undo the cast off of the entire document.
@@ -198,6 +283,24 @@ public:
      */
     void UnCastOff( );
     
+    /**
+     * @name Methods for the uuid index of the document.
+     * The index is built with the first call to FindObjectByUuid. It is then kept up to date by
+     * the Object methods modifying the tree (SetParent, SetUuid, DetachChild and the destructor)
+     * and reset only when the document is reset. The objects moved by CastOff and UnCastOff keep
+     * their entries, including the content kept aside by a progressive cast off.
+     * The objects are added and removed with their children, apart from the one with a uuid
+     * that is called for an object being deleted.
+     */
+    ///@{
+    Object *FindObjectByUuid( const std::string &uuid );
+    bool HasUuidIndex( ) { return m_uuidIndexDone; };
+    void AddToUuidIndex( Object *object, int deepness = UNLIMITED_DEPTH );
+    void RemoveFromUuidIndex( Object *object, int deepness = UNLIMITED_DEPTH );
+    void RemoveFromUuidIndex( const std::string &uuid, Object *object );
+    void ResetUuidIndex( );
+    ///@}
+    
     /**
      * To be implemented.
      */
@@ -254,6 +357,33 @@ private:
      */
     int CalcMusicFontSize( );
     
+    /**
+     * Process the document with Object::PrepareByLayer for the staff/layer states.
+     * If a list of staves is given, only these are processed (see Object::PrepareStaffLists).
+     */
+    void ProcessLayerStates( MapOfPrepareLayerStates *layerStates, ArrayOfObjects *staves );
+    
+    /**
+     * @name Methods for processing the staves with worker threads in PrepareDrawing.
+     * The maps of states (one per staff) are shared by the threads through the PrepareByLayerJob.
+     */
+    ///@{
+    static void ProcessLayerStatesJob( PrepareByLayerJob *job );
+    static void *PrepareByLayerWorker( void *param );
+    ///@}
+    
+    /**
+     * Cast off one step of a (progressive) cast off with the measures given back from the last
+     * page (if not complete) followed by the next measureCount measures kept aside.
+     */
+    void CastOffStep( int measureCount );
+    
+    /**
+     * The arena from which the objects of the document are allocated.
+     * It is declared before the other members so it is deleted after them.
+     */
+    ObjectArena m_objectArena;
+    
 public:
     /**
      * A copy of the header tree stored as pugi::xml_document
@@ -355,6 +485,55 @@ private:
      */
     bool m_drawingPreparationDone;
     
+    /**
+     * @name A flag indicating if CastOff has laid out the single system horizontally, and the widths
+     * of the scoreDef and of the labels it has given. The positions and the widths of the measures are
+     * kept in them. See Doc::CastOff. The layout is re-used by the cast off in progress if the flag was set.
+     */
+    ///@{
+    bool m_castOffLayoutDone;
+    bool m_castOffReuseLayout;
+    int m_castOffScoreDefWidth;
+    int m_castOffLabelsWidth;
+    int m_castOffAbbrLabelsWidth;
+    ///@}
+    
+    /**
+     * @name The state of a progressive cast off (see Doc::ContinueCastOff).
+     * The content not cast off yet is the children of the content system from the content index
+     * (the previous ones having been relinquished). The position is the one of its first measure
+     * in the single system, and the scoreDef width the one at the beginning of the last page.
+     */
+    ///@{
+    System *m_castOffContentSystem;
+    int m_castOffContentIdx;
+    int m_castOffContentXRel;
+    int m_castOffCurrentScoreDefWidth;
+    int m_castOffLongestActualDur;
+    int m_castOffStepMeasureCount;
+    int m_castOffMeasureCount;
+    int m_castOffPageMeasureCount;
+    ///@}
+    
+    /** The resources (path and fonts), owned by the document so each one can use its own fonts */
+    Resources m_resources;
+    
+    /** The number of threads used in PrepareDrawing */
+    int m_prepareDrawingThreads;
+    
+    /** The uuid index (see Doc::FindObjectByUuid) and a flag indicating if it has been built */
+    MapOfUuidObjects m_uuidIndex;
+    bool m_uuidIndexDone;
+    
+    /** The generator for the uuids of the objects of the document */
+    UuidGenerator m_uuidGenerator;
+    
+    /**
+     * The generators for the uuids of the objects created in PrepareDrawing for each staff @n.
+     * They are derived from m_uuidGenerator with a range of the sequence reserved for each staff.
+     */
+    MapOfStaffUuidGenerators m_staffUuidGenerators;
+    
     /** Page width (MEI scoredef@page.width) - currently not saved */
     int m_pageWidth;
     /** Page height (MEI scoredef@page.height) - currently not saved */
@@ -52,6 +52,7 @@ public:
     /**
      * Return the drawing list.
      * This is used when actually drawing the list (see View::DrawLayerList)
+     * The list is sorted and duplicates removed here and not for each element added.
      */
     ListOfObjects *GetDrawingList( );
     
@@ -68,6 +69,8 @@ public:
 private:
     /** The list of object for which drawing is postponed */
     ListOfObjects m_drawingList;
+    /** A flag indicating that objects were added since the list was last sorted */
+    bool m_drawingListUnsorted;
 };
     
 //----------------------------------------------------------------------------
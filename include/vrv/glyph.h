@@ -12,6 +12,10 @@
 #include <algorithm>
 #include <string>
 
+//----------------------------------------------------------------------------
+
+#include "pugixml.hpp"
+
 namespace vrv {
 
 /**
@@ -55,6 +59,35 @@ public:
     
     /** Get the code string */
     std::string GetCodeStr() { return m_codeStr; };
+    
+    /**
+     * @name Get the XML definition (the <symbol> element) of the glyph.
+     * This is the content of the glyph file, or of the font bundle entry when loaded
+     * from a bundle, in which case the path does not point to a file.
+     */
+    ///@{
+    bool HasXML() { return !m_xml.empty(); };
+    const std::string &GetXML() { return m_xml; };
+    ///@}
+    
+    /**
+     * @name Set and get the parsed definition.
+     * The node belongs to the document cached in Resources (see Resources::LoadFont).
+     */
+    ///@{
+    void SetDefinition( pugi::xml_node definition ) { m_definition = definition; };
+    pugi::xml_node GetDefinition() { return m_definition; };
+    ///@}
+    
+    /**
+     * @name Write and read the glyph to and from a compiled font bundle buffer.
+     * See Resources::LoadFontBundle for a description of the format.
+     * ReadBundle advances the data pointer and returns false if the buffer is truncated.
+     */
+    ///@{
+    bool WriteBundle( std::string *buffer );
+    bool ReadBundle( const char **data, const char *end );
+    ///@}
 
 private:
     
@@ -74,6 +107,10 @@ private:
     std::string m_path;
     /** The Unicode code in hexa as string */
     std::string m_codeStr;
+    /** The XML definition of the glyph as a string */
+    std::string m_xml;
+    /** The parsed XML definition of the glyph */
+    pugi::xml_node m_definition;
 };
 
 
@@ -14,6 +14,8 @@ namespace vrv {
 
 class Doc;
 class Object;
+class ObjectArena;
+class UuidGenerator;
 
 //----------------------------------------------------------------------------
 // FileOutputStream
@@ -63,6 +65,7 @@ private:
 /** 
  * This class is a base class for file input stream classes.
  * It is not an abstract class but should not be instanciate directly.
+ * The arena of the document is the current one for the lifetime of the input stream.
  */ 
 class FileInputStream: public std::ifstream
 {
@@ -76,7 +79,14 @@ public:
     
     // read
     virtual bool ImportFile( ) { return true; }
-    virtual bool ImportString( std::string data ) { return true; }
+    virtual bool ImportString( const std::string &data ) { return true; }
+    
+    /**
+     * Import the data from a buffer that can be modified and that stays valid during the import.
+     * The XML formats parse the buffer in place without copying it (see Toolkit::LoadFile).
+     * By default, the data is copied and imported with ImportString.
+     */
+    virtual bool ImportBuffer( char *buffer, size_t size ) { return ImportString( std::string( buffer, size ) ); }
     
     /**
      * Setter for the layoutInformation ignore flag
@@ -131,6 +141,16 @@ protected:
      */
     bool m_ignoreLayoutInformation;
     
+private:
+    /**
+     * The current arena before the one of the document, restored when the input stream is deleted
+     */
+    ObjectArena *m_previousArena;
+    
+    /**
+     * The current uuid generator before the one of the document, restored when the input stream is deleted
+     */
+    UuidGenerator *m_previousUuidGenerator;
     
 };
 
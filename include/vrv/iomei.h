@@ -256,7 +256,8 @@ public:
     virtual ~MeiInput();
     
     virtual bool ImportFile( );
-    virtual bool ImportString(std::string mei);
+    virtual bool ImportString(const std::string &mei);
+    virtual bool ImportBuffer(char *buffer, size_t size);
     
     /**
      * Set an xPath query for selecting specific <rdg>.
@@ -81,7 +81,8 @@ public:
     virtual ~MusicXmlInput();
     
     virtual bool ImportFile( );
-    virtual bool ImportString(std::string musicxml);
+    virtual bool ImportString(const std::string &musicxml);
+    virtual bool ImportBuffer(char *buffer, size_t size);
     
 private:
     /**
@@ -225,7 +225,7 @@ public:
     virtual ~PaeInput();
     
     virtual bool ImportFile( );
-    virtual bool ImportString(std::string pae);
+    virtual bool ImportString(const std::string &pae);
 
 #ifndef NO_PAE_SUPPORT
 
@@ -125,6 +125,15 @@ public:
      */
     virtual int PrepareRpt( ArrayPtrVoid *params );
     
+    /**
+     * @name Set and reset the state of the current staff/layer.
+     * See Object::PrepareByLayer
+     */
+    ///@{
+    virtual int PrepareByLayer( ArrayPtrVoid *params );
+    virtual int PrepareByLayerEnd( ArrayPtrVoid *params );
+    ///@}
+    
 private:
     
 public:
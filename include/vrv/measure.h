@@ -108,6 +108,17 @@ public:
      */
     int GetWidth( );
     
+    /**
+     * Return the width of the measure before the justification, including the barLine width
+     */
+    int GetNonJustifiedWidth( );
+    
+    /**
+     * Restore the X positions of the content of the measure as they were before the justification.
+     * See MeasureAligner::ResetJustification
+     */
+    void ResetJustification( ) { m_measureAligner.ResetJustification(); };
+    
     //----------//
     // Functors //
     //----------//
@@ -181,6 +192,14 @@ public:
      * It is used internally when calculating the layout and it is not stored in the file.
      */
     int m_drawingXRel;
+    /**
+     * @name The X relative position and the width of the measure in the single system laid out by Doc::CastOff.
+     * They are kept for casting off the document again without laying out the measures horizontally.
+     */
+    ///@{
+    int m_castOffXRel;
+    int m_castOffWidth;
+    ///@}
     
 private:
     bool m_measuredMusic;
@@ -12,6 +12,7 @@
 #include <iterator>
 #include <map>
 #include <string>
+#include <vector>
 
 //----------------------------------------------------------------------------
 
@@ -20,10 +21,13 @@
 
 namespace vrv {
 
+class Chord;
 class Doc;
 class EditorialElement;
 class FileOutputStream;
 class Functor;
+class MRpt;
+class Syl;
 
 /**
  * Generic int map recursive structure for storing hierachy of values
@@ -49,6 +53,175 @@ typedef std::map<int, IntTree> IntTree_t;
 typedef std::map<int, bool> VerseN_t;
 typedef std::map<int, VerseN_t> LayerN_VerserN_t;
 typedef std::map<int, LayerN_VerserN_t> StaffN_LayerN_VerseN_t;
+
+/**
+ * This holds the state of the functors processed by staff/layer (and by verse for the lyrics)
+ * in Doc::PrepareDrawing. One PrepareLayerState is created for each staff/layer @n so the
+ * document can be processed only once, each element being dispatched to the state of its
+ * staff/layer (see Object::PrepareByLayer). The ArrayPtrVoid members are the params passed
+ * to the functors and point to the other members. They are filled once the state is in the map.
+ * Since a state is modified only when processing its staff, the staves can be processed concurrently.
+ */
+struct PrepareLayerState {
+    // PrepareTieAttr and PrepareTieAttrEnd
+    std::vector<Note*> m_currentNotes;
+    Chord *m_currentChord;
+    std::vector<std::string> m_warnings;
+    ArrayPtrVoid m_tieAttrParams;
+    // PreparePointersByLayer
+    Note *m_currentNote;
+    ArrayPtrVoid m_pointersParams;
+    // PrepareLyrics and PrepareLyricsEnd - the last notes are the same for all the verses
+    Note *m_lastNote;
+    Note *m_lastButOneNote;
+    std::map<int, Syl*> m_currentSyls;
+    std::map<int, ArrayPtrVoid> m_lyricsParams;
+    // PrepareRpt
+    MRpt *m_currentMRpt;
+    data_BOOLEAN m_multiNumber;
+    ArrayPtrVoid m_rptParams;
+};
+
+typedef std::map<std::pair<int, int>, PrepareLayerState> MapOfPrepareLayerStates;
+    
+//----------------------------------------------------------------------------
+// UuidGenerator
+//----------------------------------------------------------------------------
+
+/**
+ * This class generates the uuids of the objects, that is the classid prefix followed
+ * by 15 digits. The digits are obtained from a counter with an affine permutation
+ * of [0, 10^15) derived from the seed, so they are unique for a generator and the same
+ * sequence is obtained with the same seed. The counter is incremented atomically (when
+ * supported by the compiler) without locking.
+ * The number of the uuid of an object is taken when it is constructed, with the current
+ * generator of the thread, which is set by the importers and by the Doc methods creating
+ * objects (see UuidGeneratorScope). Without current generator, the process-wide one is used.
+ * The uuid itself is written only when it is first read (see Object::GetUuid).
+ */
+class UuidGenerator
+{
+public:
+    UuidGenerator();
+    
+    /**
+     * Seed the generator and restart the sequence.
+     */
+    void Seed( unsigned int seed );
+    unsigned int GetSeed() { return m_seed; };
+    
+    /**
+     * Make the generator continue the sequence of another one from the counter first.
+     * This reserves a range of the sequence for the generator, the uuids of the two generators
+     * being unique as long as the other one does not reach first.
+     */
+    void Derive( const UuidGenerator *generator, unsigned int first );
+    
+    /**
+     * Return the number of the next uuid, to be written with UuidGenerator::Write.
+     */
+    unsigned long long Next( );
+    
+    /**
+     * Write the uuid with the prefix and the number (as 15 digits) into uuid.
+     */
+    static void Write( const std::string &prefix, unsigned long long nr, std::string *uuid );
+    
+    /**
+     * @name Get and set the current generator of the calling thread.
+     * The setter returns the previous one.
+     */
+    ///@{
+    static UuidGenerator *GetCurrent( );
+    static UuidGenerator *SetCurrent( UuidGenerator *generator );
+    ///@}
+    
+private:
+    unsigned int m_seed;
+    unsigned int m_counter;
+    unsigned long long m_multiplier;
+    unsigned long long m_offset;
+};
+
+/**
+ * This class sets the current UuidGenerator of the thread for its lifetime.
+ */
+class UuidGeneratorScope
+{
+public:
+    UuidGeneratorScope( UuidGenerator *generator ) { m_previous = UuidGenerator::SetCurrent( generator ); };
+    ~UuidGeneratorScope() { UuidGenerator::SetCurrent( m_previous ); };
+    
+private:
+    UuidGenerator *m_previous;
+};
+
+typedef std::map<int, UuidGenerator> MapOfStaffUuidGenerators;
+    
+//----------------------------------------------------------------------------
+// ObjectArena
+//----------------------------------------------------------------------------
+
+/**
+ * This class is a pool from which the objects of a document are allocated (see Object::operator new).
+ * The blocks are cut from large chunks and recycled by size when the objects are deleted. The chunks
+ * are released all at once (see Doc::Reset) when all the objects allocated from them have been deleted.
+ * The objects are allocated from the current arena of the thread, which is set by the importers and
+ * by Doc::CastOff (see ObjectArenaScope). Without current arena, the global operator new is used.
+ * The objects allocated from an arena have to be deleted in the thread using the document.
+ */
+class ObjectArena
+{
+public:
+    ObjectArena();
+    ~ObjectArena();
+    
+    /**
+     * @name Allocate and free a block of size bytes.
+     */
+    ///@{
+    void *Allocate( size_t size );
+    void Free( void *block, size_t size );
+    ///@}
+    
+    /**
+     * Release the chunks if all the blocks have been freed.
+     */
+    void Release( );
+    
+    /**
+     * @name Get and set the current arena of the calling thread.
+     * The setter returns the previous one.
+     */
+    ///@{
+    static ObjectArena *GetCurrent( );
+    static ObjectArena *SetCurrent( ObjectArena *arena );
+    ///@}
+    
+private:
+    /** The chunks from which the blocks are cut */
+    std::vector<char*> m_chunks;
+    /** The position of the next block and the space left in the last chunk */
+    char *m_next;
+    size_t m_left;
+    /** The first freed block by size class (the next one is stored in the block) */
+    std::vector<void*> m_freeBlocks;
+    /** The number of blocks allocated and not freed */
+    int m_allocatedBlocks;
+};
+    
+/**
+ * This class sets the current ObjectArena of the thread for its lifetime.
+ */
+class ObjectArenaScope
+{
+public:
+    ObjectArenaScope( ObjectArena *arena ) { m_previous = ObjectArena::SetCurrent( arena ); };
+    ~ObjectArenaScope() { ObjectArena::SetCurrent( m_previous ); };
+    
+private:
+    ObjectArena *m_previous;
+};
     
 #define UNLIMITED_DEPTH -10000
 #define FORWARD true
@@ -76,6 +249,14 @@ public:
     virtual std::string GetClassName( ) { return "[MISSING]"; };
     ///@}
     
+    /**
+     * @name Allocate the objects from the current ObjectArena, if any.
+     */
+    ///@{
+    static void *operator new( size_t size );
+    static void operator delete( void *ptr, size_t size );
+    ///@}
+    
     /**
      * @name Methods for checking if an object is part of a group of classId.
      * For example, all LayerElement child class classId is in between LAYER_ELEMENT and LAYER_ELEMENT_max.
@@ -132,9 +313,23 @@ public:
      */
     virtual Object* Clone();
     
-    std::string GetUuid() { return m_uuid; };
+    /**
+     * @name Get, set and reset the uuid.
+     * The uuid number is taken when the object is constructed and a new one when it is reset
+     * (see UuidGenerator). The uuid is written from it the first time it is read, so the first
+     * GetUuid of an object must not be called by concurrent threads.
+     */
+    ///@{
+    std::string GetUuid() const;
     void SetUuid( std::string uuid );
     void ResetUuid( );
+    ///@}
+    
+    /**
+     * Seed the process-wide UuidGenerator used when the thread has no current one.
+     * Its seed is 0 by default.
+     */
+    static void SeedUuidGenerator( unsigned int seed );
     
     /**
      * @name Children count, with or without a ClassId.
@@ -177,6 +372,8 @@ public:
     /**
      * Set the parent of the Object.
      * The current parent is expected to be NULL.
+     * The Object is added to the uuid index of the document of the parent, if any.
+     * An Object already in that index (moved within the document) keeps its entries.
      */
     void SetParent( Object *parent );
     
@@ -202,8 +399,16 @@ public:
 
     /**
      * Look for the Object in the children and return its position (-1 if not found)
+     * The search starts at startIdx, which avoids quadratic searches when processing
+     * the children in order (see Measure::CastOffSystems).
      */
-    int GetChildIndex( const Object *child );
+    int GetChildIndex( const Object *child, int startIdx = 0 );
+    
+    /**
+     * Return true if one of the previous siblings of the object matches the AttComparison.
+     * This is used for skipping staff, layer and verse with an @n already processed in the parent.
+     */
+    bool HasPreviousSiblingByAttComparison( AttComparison *attComparison );
     
     /**
      * Insert a element at the idx position.
@@ -213,8 +418,10 @@ public:
     /**
      * Detach the child at the idx position (NULL if not found)
      * The parent pointer is set to NULL.
+     * The child is removed from the uuid index unless keepInUuidIndex is true, which is
+     * for a child that will be attached again in the same document or deleted.
      */
-    Object *DetachChild( int idx );
+    Object *DetachChild( int idx, bool keepInUuidIndex = false );
     
     /**
      * Look for a child with the specified uuid (returns NULL if not found)
@@ -346,6 +553,16 @@ public:
      */
     virtual int FindByUuid( ArrayPtrVoid *params );
     
+    /**
+     * Add or remove the Object to or from the uuid index of a Doc (see Doc::FindObjectByUuid).
+     * When added, an uuid already in the index is not replaced.
+     * param 0: the pointer to the MapOfUuidObjects.
+     * param 1: a pointer to a flag indicating if the object is to be added or removed.
+     * param 2: the pointer to the Doc of the index.
+     */
+    virtual int UpdateUuidIndex( ArrayPtrVoid *params );
+    
+    
     /**
      * Find a Object with a AttComparison functor .
      * param 0: the pointer to the AttComparsion we are evaluating.
@@ -535,8 +752,10 @@ public:
      * Matches start and end for TimeSpanningInterface elements (such as tie or slur)
      * If fillList is set to false, the only the remaining elements will be matched.
      * This is used when processing a second time in the other direction
-     * param 0: std::vector<DocObject*>* that holds the current elements to match
+     * param 0: std::vector<DocObject*>* that holds all the elements to match
      * param 1: bool* fillList for indicating whether the elements have to be stack or not
+     * param 2: MapOfUuidTimeSpanningInterfaces* of the elements with a start still to match (by uuid)
+     * param 3: MapOfUuidTimeSpanningInterfaces* of the elements with an end still to match (by uuid)
      */
     virtual int PrepareTimeSpanning( ArrayPtrVoid *params ) { return FUNCTOR_CONTINUE; };
     
@@ -545,6 +764,7 @@ public:
      * at the Pname and Oct
      * param 0: std::vector<Note*>* that holds the current notes with open ties
      * param 1: Chord** currentChord for the current chord if in a chord
+     * param 2: std::vector<std::string>* for the warnings to be logged once all the layers are processed
      */
     virtual int PrepareTieAttr( ArrayPtrVoid *params ) { return FUNCTOR_CONTINUE; };
     
@@ -553,6 +773,7 @@ public:
      * Chord pointer to NULL at the end of a chord
      * param 0: std::vector<Note*>* that holds the current notes with open ties (unused)
      * param 1: Chord** currentChord for the current chord if in a chord
+     * param 2: std::vector<std::string>* for the warnings (unused)
      */
     virtual int PrepareTieAttrEnd( ArrayPtrVoid *params ) { return FUNCTOR_CONTINUE; };
     
@@ -566,7 +787,7 @@ public:
     
     /**
      * Functor for setting wordpos and connector ends
-     * The functor is process by staff/layer/verse using an ArrayOfAttComparisons filter.
+     * The functor is process by staff/layer/verse through Object::PrepareByLayer.
      */
     virtual int PrepareLyrics( ArrayPtrVoid *params )  { return FUNCTOR_CONTINUE; };
     
@@ -578,13 +799,37 @@ public:
     
     /**
      * Functor for setting mRpt drawing numbers (if required)
-     * The functor is process by staff/layer using an ArrayOfAttComparisons filter.
+     * The functor is process by staff/layer through Object::PrepareByLayer.
      * param 0: MRpt **currentMRpt
      * param 1: data_BOOLEAN for indicating if the MRpt::m_drawingNumber has to be set or not
      * param 2: ScoreDef * doc scoreDef
      */
     virtual int PrepareRpt( ArrayPtrVoid *params ) { return FUNCTOR_CONTINUE; };
     
+    /**
+     * Processes the document once for all the functors processed by staff/layer/verse above
+     * (PrepareTieAttr, PreparePointersByLayer, PrepareLyrics and PrepareRpt). Staff, Layer and
+     * Verse set the current state and the other objects are dispatched to it.
+     * param 0: MapOfPrepareLayerStates* the states for each staff/layer
+     * param 1: PrepareLayerState** the state of the current staff/layer (NULL if none)
+     * param 2: Staff** the current staff
+     * param 3: ArrayPtrVoid** the PrepareLyrics params of the current verse (NULL if none)
+     */
+    virtual int PrepareByLayer( ArrayPtrVoid *params );
+    
+    /**
+     * End functor for Object::PrepareByLayer, resetting the current state.
+     * It also calls PrepareTieAttrEnd.
+     */
+    virtual int PrepareByLayerEnd( ArrayPtrVoid *params );
+    
+    /**
+     * Fill the lists of the staves processed by Object::PrepareByLayer for each staff @n, in the
+     * order of the document. This is used for processing the staves concurrently in Doc::PrepareDrawing.
+     * param 0: std::map<int, ArrayOfObjects>* the staves for each staff @n
+     */
+    virtual int PrepareStaffLists( ArrayPtrVoid *params ) { return FUNCTOR_CONTINUE; };
+    
     /**
      * Goes through all the TimeSpanningInterface element and set them a current to each staff
      * where require. For Note with DrawingTieAttr, the functor is redireted to the tie object
@@ -666,12 +911,20 @@ public:
     ArrayOfStrAttr m_unsupported;
     
 protected:
-    std::string m_uuid;
+    /**
+     * The uuid, written from m_uuidNr when first read (see Object::GetUuid).
+     * m_uuidNr is UUID_WRITTEN once m_uuid is written or set.
+     */
+    mutable std::string m_uuid;
+    mutable unsigned long long m_uuidNr;
     std::string m_classid;
     std::wstring m_text;
 
 private:
     
+    /**
+     * Take the uuid number from the current UuidGenerator of the thread, or the process-wide one.
+     */
     void GenerateUuid();
     void Init(std::string);
     
@@ -700,6 +953,13 @@ private:
      * A vector for storing the list of InterfaceId (group of MEI att classes) implemented.
      */
     std::vector<InterfaceId> m_interfaces;
+    
+    /**
+     * The Doc in the uuid index of which the Object was added (NULL if none).
+     * It is passed down to the children when they are attached and the Object removes
+     * itself from the index when it is deleted.
+     */
+    Doc *m_uuidIndexDoc;
 };
 
 //----------------------------------------------------------------------------
@@ -784,6 +1044,7 @@ public:
 
     /**
      * Look for the Object in the list and return its position (-1 if not found)
+     * The position is looked for in an index built with the list, as for the methods below.
      */
     int GetListIndex( const Object *listElement );
     
@@ -811,9 +1072,36 @@ public:
      */
     ListOfObjects *GetList( Object *node );
     
+private:
+    /**
+     * Build the array and the index for random access to the list.
+     * Called when the list is reset.
+     */
+    void IndexList( );
+    
+    /**
+     * Return the slot of the Object in m_listIndexes, or of the empty slot where it goes.
+     * m_listIndexes is expected not to be empty.
+     */
+    int GetListIndexSlot( const Object *listElement );
+    
 private:
     ListOfObjects m_list;
     ListOfObjects::iterator m_iteratorCurrent;
+    /** A copy of the list for random access */
+    ArrayOfObjects m_listArray;
+    /**
+     * The position of each object in the list.
+     * This is a hash table with open addressing (linear probing), whose size is a power of two
+     * and at least twice the size of the list. Empty slots have a NULL object.
+     */
+    std::vector<std::pair<const Object*, int> > m_listIndexes;
+    /**
+     * For each ClassId looked for with GetListFirstBackward, the position of the previous
+     * object of that class for each position in the list (-1 if none).
+     * It is filled on demand and cleared when the list is reset.
+     */
+    std::map<ClassId, std::vector<int> > m_listPreviousIndexes;
     
 protected:
     /**
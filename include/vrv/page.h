@@ -66,13 +66,34 @@ public:
      * Do the layout of the page, which means aligning its content horizontally
      * and vertically, and justify horizontally and vertically if wanted.
      * This will be done only if m_layoutDone is false or force is true.
+     * Otherwise, only the measures modified since are laid out again (see Page::LayOutModified).
      */
     void LayOut( bool force = false );
     
     /**
-     * Lay out the content of the page (measures and their content) horizontally
+     * Mark the layout of the page as not done, for example when its scoreDef has been set again.
+     * The page will be laid out again the next time it is drawn.
      */
-    void LayOutHorizontally( );
+    void ResetLayout( ) { m_layoutDone = false; };
+    
+    /**
+     * Lay out again the measures modified since the layout of the page was done and justify the page.
+     * The measures are marked as modified with Object::Modify, which also marks their system and the page.
+     * The measure breaks are kept but the method returns true if they have changed in one of the modified
+     * systems. The document needs to be cast off again in that case (see Toolkit::RedoLayout).
+     */
+    bool LayOutModified( );
+    
+    /**
+     * Lay out the content of the page (measures and their content) horizontally.
+     * The spacing uses the longest duration of the page unless one is given (see Doc::CastOff).
+     */
+    void LayOutHorizontally( int longestActualDur = VRV_UNSET );
+    
+    /**
+     * Return the longest duration (DUR_* code) of the page
+     */
+    int GetLongestActualDur( );
     
     /**
      * Justifiy the content of the page (measures and their content) horizontally
@@ -109,6 +130,16 @@ public:
     //----------//
     
 private:
+    /**
+     * Lay out horizontally the content of the objects (the page or some of its measures).
+     * The other measures are not aligned again but they are all positioned in their system.
+     */
+    void LayOutHorizontally( ArrayOfObjects *objects, int longestActualDur = VRV_UNSET );
+    
+    /**
+     * Mark the page, its systems and their measures as not modified once they have been laid out
+     */
+    void ResetModified( );
     
 public:
     /** Page width (MEI scoredef@page.width). Saved if != -1 */
@@ -143,6 +174,11 @@ private:
      */
     bool m_layoutDone;
     
+    /**
+     * The longest duration (DUR_* code) used for the spacing when the page was laid out.
+     */
+    int m_drawingLongestActualDur;
+    
 };
 
 } // namespace vrv
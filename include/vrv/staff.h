@@ -117,6 +117,18 @@ public:
      */
     virtual int PrepareRpt( ArrayPtrVoid *params );
     
+    /**
+     * Set the current staff.
+     * See Object::PrepareByLayer
+     */
+    virtual int PrepareByLayer( ArrayPtrVoid *params );
+    
+    /**
+     * Add the staff to the list of its @n.
+     * See Object::PrepareStaffLists
+     */
+    virtual int PrepareStaffLists( ArrayPtrVoid *params );
+    
 public:
 	/**
      * Number of lines copied from the staffDef for fast access when drawing
@@ -0,0 +1,210 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:        streamingsvgdevicecontext.h
+// Author:      Laurent Pugin
+// Created:     2015
+// Copyright (c) Authors and others. All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef __VRV_STREAMING_SVG_DC_H__
+#define __VRV_STREAMING_SVG_DC_H__
+
+#include <map>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------
+
+#include "devicecontext.h"
+
+namespace vrv {
+
+class Glyph;
+
+//----------------------------------------------------------------------------
+// StreamingSvgDeviceContext
+//----------------------------------------------------------------------------
+
+/**
+ * This class implements a drawing context for generating SVG files without building a DOM.
+ * The SVG is written as text into a pre-reserved buffer as the drawing calls arrive.
+ * The <defs>, the text font and the width and height of the SVG are known only at the end
+ * of the page and are added when the SVG is committed.
+ * The output is the same as the one of the SvgDeviceContext.
+ */
+class StreamingSvgDeviceContext: public DeviceContext
+{
+public:
+    /**
+     * @name Constructors, destructors, and other standard methods
+     */
+    ///@{
+    StreamingSvgDeviceContext ( int width, int height );
+    virtual ~StreamingSvgDeviceContext();
+    ///@}
+
+    /**
+     * @name Setters
+     */
+    ///@{
+    virtual void SetBackground( int colour, int style = AxSOLID );
+    virtual void SetBackgroundImage( void *image, double opacity = 1.0 );
+    virtual void SetBackgroundMode( int mode );
+    virtual void SetTextForeground( int colour );
+    virtual void SetTextBackground( int colour );
+    virtual void SetLogicalOrigin( int x, int y );
+    virtual void SetUserScale( double xScale, double yScale );
+    ///@}
+
+    /**
+     * @name Getters
+     */
+    ///@{
+    virtual Point GetLogicalOrigin( );
+    ///}
+
+    /**
+     * Get the the SVG into a string
+     * Add the xml tag if necessary.
+     */
+    std::string GetStringSVG( bool xml_declaration = false );
+
+    /**
+     * @name Drawing methods
+     */
+    ///@{
+    virtual void DrawComplexBezierPath(int x, int y, int bezier1_coord[6], int bezier2_coord[6]);
+    virtual void DrawCircle(int x, int y, int radius);
+    virtual void DrawEllipse(int x, int y, int width, int height);
+    virtual void DrawEllipticArc(int x, int y, int width, int height, double start, double end);
+    virtual void DrawLine(int x1, int y1, int x2, int y2);
+    virtual void DrawPolygon(int n, Point points[], int xoffset, int yoffset, int fill_style = AxODDEVEN_RULE);
+    virtual void DrawRectangle(int x, int y, int width, int height);
+    virtual void DrawRotatedText(const std::string& text, int x, int y, double angle);
+    virtual void DrawRoundedRectangle(int x, int y, int width, int height, double radius);
+    virtual void DrawText(const std::string& text, const std::wstring wtext = L"");
+    virtual void DrawMusicText(const std::wstring& text, int x, int y);
+    virtual void DrawSpline(int n, Point points[]);
+    virtual void DrawBackgroundImage( int x = 0, int y = 0 );
+    ///@}
+
+    /**
+     * @name Method for starting and ending a text
+     */
+    ///@{
+    virtual void StartText(int x, int y, char alignement = LEFT );
+    virtual void EndText();
+
+    /**
+     * @name Method for starting and ending a graphic
+     */
+    ///@{
+    virtual void StartGraphic( DocObject *object, std::string gClass, std::string gId );
+    virtual void EndGraphic( DocObject *object, View *view  );
+    ///@}
+
+    /**
+     * @name Methods for re-starting and ending a graphic for objects drawn in separate steps
+     * Since the group might already have been written, the content is written in a separate
+     * buffer that is inserted at the end of the group when the SVG is committed.
+     */
+    ///@{
+    virtual void ResumeGraphic( DocObject *object, std::string gId );
+    virtual void EndResumedGraphic( DocObject *object, View *view  );
+    ///@}
+
+    /**
+     * @name Method for starting and ending page
+     */
+    ///@{
+    virtual void StartPage();
+    virtual void EndPage();
+    ///@}
+
+private:
+
+    /**
+     * An element written (or being written) to one of the buffers.
+     * Elements are kept once closed because the content of resumed graphics needs to
+     * be inserted at their end.
+     */
+    struct Element {
+        /** The name of the element */
+        const char *m_name;
+        /** The buffer (index in m_buffers) in which the element is written */
+        int m_buffer;
+        /** The indentation depth of the element */
+        int m_depth;
+        /** A flag indicating that the start tag has been closed with '>' */
+        bool m_hasChildren;
+        /** A flag indicating that the element has been closed */
+        bool m_closed;
+        /** The position of the end of the content in the buffer when closed */
+        size_t m_endPos;
+        /** The buffers with the content of the resumed graphics */
+        std::vector<int> m_resumedBuffers;
+    };
+
+    /**
+     * @name Methods for writing the elements.
+     * Opening a child element closes the start tag of its parent if necessary.
+     * Elements without children are closed as empty elements.
+     */
+    ///@{
+    std::string *OpenChild( );
+    void StartElement( const char *name );
+    void EndElement( );
+    ///@}
+
+    /**
+     * @name Methods for writing attributes and text.
+     * They apply to the buffer of the current element.
+     */
+    ///@{
+    void WriteAttribute( std::string *buffer, const char *name, const std::string &value );
+    void WriteAttribute( std::string *buffer, const char *name, int value );
+    void WriteEscaped( std::string *buffer, const std::string &value, bool attribute );
+    void WriteInt( std::string *buffer, int value );
+    void WriteIndent( std::string *buffer, int depth );
+    ///@}
+
+    /**
+     * Append the content of a buffer to the output, with the content of the resumed
+     * graphics inserted at the end of the corresponding groups.
+     */
+    void AppendBuffer( int buffer, std::string *output, std::vector<bool> *visited );
+
+    /**
+     * Flush the data to the output buffer.
+     * Adds the xml tag if necessary and the <defs> from m_smufl_glyphs
+     */
+    void Commit( bool xml_declaration );
+
+    // the output as a string, filled when the SVG is committed
+    std::string m_outdata;
+
+    bool m_committed; // did we flushed the file?
+    int m_width, m_height;
+    int m_originX, m_originY;
+    double m_userScaleX, m_userScaleY;
+
+    // holds the list of glyphs from the smufl font used so far
+    // they will be added at the end of the file as <defs>
+    std::vector<Glyph*> m_smufl_glyphs;
+
+    /** The buffers, the first one being the main content of the SVG */
+    std::vector<std::string> m_buffers;
+    /** All the elements written so far */
+    std::vector<Element> m_elements;
+    /** The stack of the elements currently opened (index in m_elements) */
+    std::vector<int> m_elementStack;
+    /** The groups by id (index in m_elements) for resuming them */
+    std::map<std::string, int> m_groups;
+    /** The groups that have been resumed (index in m_elements) */
+    std::vector<int> m_resumedGroups;
+
+};
+
+} // namespace vrv
+
+#endif // __VRV_STREAMING_SVG_DC_H__
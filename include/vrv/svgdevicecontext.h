@@ -12,6 +12,7 @@
 #include <iostream>
 #include <fstream>
 #include <list>
+#include <map>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -22,6 +23,8 @@
 #include "pugixml.hpp"
 
 namespace vrv {
+    
+class Glyph;
 
 //----------------------------------------------------------------------------
 // BBoxDeviceContext
@@ -139,7 +142,7 @@ private:
       
     // holds the list of glyphs from the smufl font used so far
     // they will be added at the end of the file as <defs>
-    std::vector<std::string> m_smufl_glyphs;
+    std::vector<Glyph*> m_smufl_glyphs;
     
     /**
      * Flush the data to the internal buffer.
@@ -156,6 +159,8 @@ private:
     pugi::xml_node m_svgNode;
     pugi::xml_node m_currentNode;
     std::list<pugi::xml_node> m_svgNodeStack;
+    // the groups by id for resuming them without searching the document
+    std::map<std::string, pugi::xml_node> m_groups;
     
 };
 
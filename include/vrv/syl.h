@@ -50,11 +50,18 @@ public:
     
     /**
      * Functor for setting wordpos and connector ends
-     * The functor is process by staff/layer/verse using an ArrayOfAttComparisons filter
+     * The functor is process by staff/layer/verse through Object::PrepareByLayer
      * See PrepareDarwing
      */
     virtual int PrepareLyrics( ArrayPtrVoid *params );
     
+    /**
+     * Call PrepareLyrics with the params of the current verse, or of all the verses
+     * of the layer when the syl is not within a verse.
+     * See Object::PrepareByLayer
+     */
+    virtual int PrepareByLayer( ArrayPtrVoid *params );
+    
     /**
      * See Object::FillStaffCurrentTimeSpanning
      */
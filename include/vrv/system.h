@@ -85,6 +85,14 @@ public:
      */
     int GetSystemIdx() const { return Object::GetIdx(); };
     
+    /**
+     * Return true if the measures would not be cast off in the same systems anymore, i.e., if the
+     * system became too narrow for its measures or if the next measure (the first one of the next
+     * system, NULL if none) now fits in it. The measures have to be aligned (see Page::LayOutModified).
+     * This is checked only if the system was cast off (see Measure::CastOffSystems).
+     */
+    bool HaveMeasureBreaksChanged( Measure *nextMeasure );
+    
     //----------//
     // Functors //
     //----------//
@@ -193,6 +201,11 @@ public:
     ///@{
     int m_drawingTotalWidth;
     ///@}
+    /**
+     * The width that was available for the measures when the system was cast off.
+     * It is VRV_UNSET if the system was not cast off (e.g., with the layout of the file).
+     */
+    int m_drawingCastOffWidth;
 
 private:
     
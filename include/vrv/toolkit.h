@@ -11,10 +11,6 @@
 
 #include <string>
 
-#ifdef USE_EMSCRIPTEN
-#include "jsonxx.h"
-#endif
-
 #include "utf8.h"
 
 //----------------------------------------------------------------------------
@@ -22,6 +18,13 @@
 #include "doc.h"
 #include "view.h"
 
+#ifdef USE_EMSCRIPTEN
+// only used by the editor methods, so jsonxx.h is not needed for including the toolkit
+namespace jsonxx {
+class Object;
+}
+#endif
+
 namespace vrv {
 
 typedef enum {
@@ -30,6 +33,8 @@ typedef enum {
     DARMS,
     MUSICXML
 } FileFormat;
+    
+class FileInputStream;
 
 
 //----------------------------------------------------------------------------
@@ -43,24 +48,33 @@ public:
      * @name Constructors and destructors
      */
     ///@{
-    /** If initFont is set to false, Resources::InitFonts will have to be called explicitely */
+    /** If initFont is set to false, the fonts will have to be loaded with SetResourcePath */
     Toolkit( bool initFont = true );
     virtual ~Toolkit();
     ///@}
 
     /**
-     * Set the resource path. To be called if the constructor had initFont=false.
-     * This needs refactoring.
+     * Set the resource path and load the fonts from it (see Resources::InitFonts).
+     * To be called if the constructor had initFont=false. The path and the fonts are the ones of this toolkit only.
      */
     bool SetResourcePath( const std::string &path );
     
     /**
      * Load a file with the specified type.
+     * The file is memory-mapped and given to the importer as a buffer, which the XML
+     * formats parse in place (see FileInputStream::ImportBuffer).
      */
     bool LoadFile( const std::string &filename );
     
+    /**
+     * Copy the options of another toolkit (but not its data).
+     * This can be used for resetting the options of a toolkit re-used for several files.
+     */
+    void CopyOptions( Toolkit *toolkit );
+    
     /**
      * Load a string data witht he specified type.
+     * UTF-16 data (with a BOM) is converted to UTF-8.
      */
     bool LoadString( const std::string &data );
     
@@ -102,7 +116,7 @@ public:
     
     /**
      * Render the page in SVG and returns it as a string
-     * Page number is 1-based
+     * Page number is 1-based. An empty string is returned if the page does not exist.
      */
     std::string RenderToSvg( int pageNo =  1, bool xml_declaration = false );
 
@@ -115,6 +129,7 @@ public:
     /**
      * Get the MEI as a string.
      * Get all the pages unless a page number (1-based) is specified
+     * An empty string is returned if the page does not exist.
      */
     std::string GetMEI( int pageNo =  0, bool scoreBased = false );
     
@@ -130,6 +145,19 @@ public:
      */
     void RedoLayout();
     
+    /**
+     * @name Get the system breaks for several page widths (in pixels) without redoing the layout for each of them
+     * GetSystemBreaks fills breaks with the indexes (0-based) of the measures starting a new system for each
+     * page width. GetSystemBreakWidths returns the page widths, from minWidth to maxWidth, at which the
+     * breaks change (starting with minWidth), i.e., the pages need to be laid out again only for these widths.
+     * The breaks are computed from the horizontal layout kept by the document, with the border of the last
+     * layout. The layout is redone (see RedoLayout) only if it is not available.
+     */
+    ///@{
+    bool GetSystemBreaks( const std::vector<int> &pageWidths, std::vector<std::vector<int> > *breaks );
+    std::vector<int> GetSystemBreakWidths( int minWidth, int maxWidth );
+    ///@}
+    
     /**
      * Return the page on which the element is the ID (xml:id) is rendered
      * This takes into account the current layout options.
@@ -256,6 +284,41 @@ public:
     int GetShowBoundingBoxes() { return m_showBoundingBoxes; };
     ///@}
     
+    /**
+     * @name Write the SVG directly as text instead of building a DOM (see StreamingSvgDeviceContext)
+     */
+    ///@{
+    void SetStreamingSvg( bool s ) { m_streamingSvg = s; };
+    int GetStreamingSvg() { return m_streamingSvg; };
+    ///@}
+    
+    /**
+     * @name Cast off the pages progressively, only up to the page rendered (see Doc::CastOff)
+     * GetPageCount returns an estimate until all the pages have been cast off. For checking
+     * a page number, the pages have to be cast off up to it first (see ContinueLayout).
+     */
+    ///@{
+    void SetProgressiveLayout( bool p ) { m_progressiveLayout = p; };
+    int GetProgressiveLayout() { return m_progressiveLayout; };
+    ///@}
+    
+    /**
+     * @name Number of threads for preparing the drawing, the staves being processed concurrently
+     */
+    ///@{
+    bool SetThreads( int threads );
+    int GetThreads() { return m_threads; };
+    ///@}
+    
+    /**
+     * @name Seed of the uuids generated for the elements without xml:id in the document of the toolkit
+     * The same seed gives the same uuids. By default (-1) the seed is taken from std::rand().
+     */
+    ///@{
+    bool SetUuidSeed( int uuidSeed );
+    int GetUuidSeed() { return m_uuidSeed; };
+    ///@}
+    
     /**
      * @name Get the input file format (defined as FileFormat)
      * The SetFormat with FileFormat does not perform any validation
@@ -284,6 +347,7 @@ public:
 
     /**
      * @name Set a specific font
+     * The font is selected for this toolkit only (see Resources::SetFont)
      */
     ///@{
     bool SetFont( std::string const &font );
@@ -297,6 +361,13 @@ public:
     int GetPageCount( );
     ///@}
     
+    /**
+     * Continue the progressive cast off until the page is laid out, or until the end by default.
+     * Page number is 1-based. Does nothing when the document is fully cast off.
+     * The page count is exact afterwards for checking the page number.
+     */
+    void ContinueLayout( int pageNo = 0 );
+    
     /**
      * Experimental editor method
      */
@@ -307,9 +378,47 @@ public:
     ///@}
 
 private:
-    bool IsUTF16( const std::string &filename );
-    bool LoadUTF16File( const std::string &filename );
+    /**
+     * @name Methods for loading UTF-16 data (with a BOM) from LoadFile or LoadString
+     */
+    ///@{
+    bool IsUTF16( const char *data, size_t size );
+    bool LoadUTF16Data( const char *data, size_t size );
+    ///@}
     
+    /**
+     * Draw the current page of the view in the device context with the user options.
+     */
+    void DrawCurrentPage( DeviceContext *dc );
+    
+    /**
+     * @name Methods shared by LoadFile and LoadString
+     * CreateInput returns a new input stream for the format with the user options (NULL on error).
+     * LoadInput lays out the document imported by the input stream and deletes it.
+     */
+    ///@{
+    FileInputStream *CreateInput( );
+    bool LoadInput( FileInputStream *input );
+    ///@}
+    
+    /**
+     * Return the element with the ID (xml:id) on the current drawing page (NULL if not found).
+     * The element is looked for with the uuid index of the document.
+     */
+    Object *FindDrawingPageElement( const std::string &xmlId );
+    
+    /**
+     * Lay out again the drawing page after the element has been edited.
+     * Only its measure (or the whole page if it is not within a measure) is aligned again and the document
+     * is cast off again with Toolkit::RedoLayout only if the measure breaks change (see Page::LayOutModified).
+     */
+    void LayOutModified( Object *element );
+    
+    /**
+     * Make sure the horizontal layout for computing the system breaks is available.
+     * Return false if no document is loaded or if the layout cannot be kept (see Doc::CastOff).
+     */
+    bool PrepareSystemBreaks( );
     
 protected:
 #ifdef USE_EMSCRIPTEN
@@ -347,9 +456,13 @@ private:
     bool m_evenNoteSpacing;
     float m_spacingLinear;
     float m_spacingNonLinear;
+    int m_threads;
+    int m_uuidSeed;
     // for debugging
     bool m_noJustification;
     bool m_showBoundingBoxes;
+    bool m_streamingSvg;
+    bool m_progressiveLayout;
 	
 	char *m_cString;
 };
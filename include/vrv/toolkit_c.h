@@ -0,0 +1,88 @@
+/****************************************************************************
+ * Name:        toolkit_c.h
+ * Author:      Laurent Pugin
+ * Created:     2015
+ * Copyright (c) Authors and others. All rights reserved.
+ ****************************************************************************/
+
+
+#ifndef __VRV_TOOLKIT_C_H__
+#define __VRV_TOOLKIT_C_H__
+
+#include <stddef.h>
+
+/**
+ * This is the C interface of the Toolkit for embedding verovio with the static or the shared library.
+ * It can be used from C and from any language with a C foreign function interface.
+ * The toolkit is an opaque handle. The functions returning an int return 1 on success and 0 on error,
+ * apart from vrvToolkit_getPageCount that returns a count (0 on error).
+ * No exception goes through the interface: they are logged and reported as errors.
+ * A toolkit can be used by one thread at a time, but several toolkits can be used in parallel,
+ * each with its own resource path and font (the fonts are not global to the library).
+ *
+ * The output (SVG or MEI) is written into a buffer given by the caller. The functions return
+ * the length of the output (without the terminating null character), as snprintf does, so the
+ * output was truncated if the returned length is >= the size of the buffer. In that case, the
+ * output is kept and calling the function again with a large enough buffer only copies it.
+ * A NULL buffer with a size of 0 can be given for getting the length first.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct vrvToolkit vrvToolkit;
+
+/**
+ * Create a toolkit and load the fonts from the resource path (the default one if NULL).
+ * Return NULL if the fonts could not be loaded.
+ */
+vrvToolkit *vrvToolkit_create( const char *resourcePath );
+
+/**
+ * Delete the toolkit.
+ */
+void vrvToolkit_destroy( vrvToolkit *tk );
+
+/**
+ * Set an option given by its name as in Toolkit::ParseOptions (e.g., "scale", "pageWidth", "noLayout")
+ * or "format" and "font". The value is given as a string ("1" or "true" for the flags).
+ */
+int vrvToolkit_setOption( vrvToolkit *tk, const char *name, const char *value );
+
+/**
+ * @name Load a file or the data of a buffer (which does not have to be null-terminated)
+ */
+/** @{ */
+int vrvToolkit_loadFile( vrvToolkit *tk, const char *filename );
+int vrvToolkit_loadData( vrvToolkit *tk, const char *data, size_t size );
+/** @} */
+
+/**
+ * Return the number of pages of the loaded document.
+ * Unlike the other functions returning an int, this is a count and not a success flag.
+ * Return 0 on error (NULL toolkit or exception), which cannot be distinguished from a document
+ * without pages.
+ */
+int vrvToolkit_getPageCount( vrvToolkit *tk );
+
+/**
+ * Redo the layout of the loaded document with the current options.
+ */
+void vrvToolkit_redoLayout( vrvToolkit *tk );
+
+/**
+ * @name Write the output into the buffer and return its length (-1 on error)
+ * The page number is 1-based. For the MEI, a page number of 0 gives all the pages.
+ */
+/** @{ */
+long vrvToolkit_renderPage( vrvToolkit *tk, int pageNo, char *buffer, size_t size );
+long vrvToolkit_getMEI( vrvToolkit *tk, int pageNo, int scoreBased, char *buffer, size_t size );
+long vrvToolkit_getVersion( char *buffer, size_t size );
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
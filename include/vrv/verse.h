@@ -58,6 +58,15 @@ public:
      */
     virtual int PrepareProcessingLists( ArrayPtrVoid *params );
     
+    /**
+     * @name Set and reset the PrepareLyrics params of the current verse.
+     * See Object::PrepareByLayer
+     */
+    ///@{
+    virtual int PrepareByLayer( ArrayPtrVoid *params );
+    virtual int PrepareByLayerEnd( ArrayPtrVoid *params );
+    ///@}
+    
 protected:
 
 private:
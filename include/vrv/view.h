@@ -436,13 +436,10 @@ protected:
     ScoreDef m_drawingScoreDef;
     
 private:
-    /** buffer for De-Casteljau algorithm */
-    static int s_deCasteljau[4][4];
-    
     /** @name Internal values for storing temporary values for ligatures */
     ///@{
-    static int s_drawingLigX[2], s_drawingLigY[2];   
-    static bool s_drawingLigObliqua;
+    int m_drawingLigX[2], m_drawingLigY[2];
+    bool m_drawingLigObliqua;
     ///@}
 
 };
@@ -17,6 +17,10 @@
 #include <sys/time.h>
 #include <vector>
 
+//----------------------------------------------------------------------------
+
+#include "pugixml.hpp"
+
 namespace vrv {
     
 class Glyph;
@@ -57,6 +61,13 @@ std::string UTF16to8(const wchar_t * in);
  */
 std::wstring UTF8to16(const char * in);
     
+/**
+ * Utility for converting a UTF-16 buffer to UTF-8.
+ * The byte order is given by the BOM (which is skipped) and is little-endian without one.
+ * Return false if the buffer contains an unpaired surrogate.
+ */
+bool UTF16BufferTo8(const char * data, size_t size, std::string *out);
+    
 /**
  * Format a string using vsnprintf.
  * The maximum length is giving by STRING_FORMAT_MAX_LEN
@@ -112,43 +123,117 @@ bool Check( Object *object );
 //----------------------------------------------------------------------------
 
 /**
- * This class provides static resource values.
- * The default values can be changed by setters.
+ * The glyphs of a combination of SMuFL fonts (e.g., Leipzig over Bravura), by code
+ */
+typedef std::map<wchar_t, Glyph*> MapOfCodeGlyphs;
+    
+struct TextFont;
+
+/**
+ * This class provides the resource path and the fonts used by a document (see Doc::GetResources).
+ * The fonts are loaded once per resource path and shared by all the instances. Loaded fonts
+ * and combinations of fonts are never modified, and each instance only points to the ones it
+ * uses, so instances can be used from several threads. Loading fonts is serialized.
  */
 
 class Resources
 {
 public:
+    /**
+     * @name Constructors, destructors, and other standard methods
+     * The path is the default one and no font is used until InitFonts is called.
+     */
+    ///@{
+    Resources( );
+    virtual ~Resources( ) {};
+    ///@}
 
     /**
-     * @name Setters and getters for static environment variables
+     * @name Setters and getters for the resource path of the instance
+     * The fonts are not loaded again from the new path until InitFonts is called.
+     */
+    ///@{
+    std::string GetPath( ) const { return m_path; };
+    void SetPath( std::string path ) { m_path = path; };
+    ///@}
+    
+    /**
+     * @name Setters and getters for the default resource path given to new instances
+     */
+    ///@{
+    static std::string GetDefaultPath( );
+    static void SetDefaultPath( std::string path );
+    ///@}
+    
+    /**
+     * Load the default SMuFL fonts (Bravura and Leipzig) and the text font from the resource path
+     * if not loaded yet, and use them in this instance (Leipzig over Bravura).
+     */
+    bool InitFonts( );
+    
+    /**
+     * Use a SMuFL font on top of the fonts used so far in this instance (loading it if necessary).
+     */
+    bool SetFont( std::string fontName );
+    
+    /**
+     * @name Getters for the glyphs used by the instance
      */
     ///@{
-    /** Resource path */
-    static std::string GetPath( ) { return m_path; };
-    static void SetPath( std::string path ) { m_path = path; };
-    /** Init the SMufL music and text fonts */
-    static bool InitFonts( );
-    /** Init the text font (bounding boxes and ASCII only) */
-    static bool InitTextFont( );
-    /** Select a particular font */
-    static bool SetFont( std::string fontName );
     /** Returns the glyph (if exists) for the current SMuFL font */
-    static Glyph* GetGlyph( wchar_t smuflCode );
+    Glyph* GetGlyph( wchar_t smuflCode ) const;
     /** Returns the glyph (if exists) for the text font (bounding box and ASCII only) */
-    static Glyph* GetTextGlyph( wchar_t code );
+    Glyph* GetTextGlyph( wchar_t code ) const;
+    /** Returns the woff VerovioText font definition (empty if not loaded) */
+    pugi::xml_node GetTextFontDefinition( ) const;
     ///@}
     
+    /**
+     * Compile a font from its XML directory (and bounding box file) in path into a binary bundle.
+     * The bundle is then loaded in one read by InitFonts / SetFont when found in the resource path.
+     * It stores the number and the last modification time of the XML files and it is not used
+     * when they do not match anymore (see GetFontXMLStamp).
+     */
+    static bool CreateFontBundle( std::string path, std::string fontName, std::string filename );
+    
 private:
-    static bool LoadFont(std::string fontName);
+    /**
+     * @name Methods for loading the fonts, to be called with the resources locked
+     */
+    ///@{
+    static bool LoadFont( const std::string &path, const std::string &fontName );
+    static const MapOfCodeGlyphs *GetFontSet( const std::string &path, const std::vector<std::string> &fontNames );
+    static const TextFont *LoadTextFont( const std::string &path );
+    static bool LoadFontBundle( const std::string &path, const std::string &fontName, std::map<wchar_t, Glyph> *font );
+    static bool LoadFontXML( const std::string &path, const std::string &fontName, std::map<wchar_t, Glyph> *font );
+    ///@}
+    
+    /**
+     * Get the number of XML files of a font (the glyphs and the bounding box file) and their last
+     * modification time. Return false if the font directory cannot be read.
+     */
+    static bool GetFontXMLStamp( const std::string &path, const std::string &fontName, int *fileCount, long long *lastModified );
     
 private:
     /** The path to the resources directory (e.g., for the svg/ subdirectory with fonts as XML */
-    static std::string m_path;
-    /** The loaded SMuFL font */
-    static std::map<wchar_t, Glyph> m_font;
-    /** A text font used for bounding box calculations */
-    static std::map<wchar_t, Glyph> m_textFont;
+    std::string m_path;
+    /** The names of the fonts used, the last one being on top */
+    std::vector<std::string> m_fontNames;
+    /** The SMuFL fonts used (one of m_fontSets) */
+    const MapOfCodeGlyphs *m_font;
+    /** The text font used (one of m_textFonts) */
+    const TextFont *m_textFont;
+    
+    /** The default path for new instances */
+    static std::string m_defaultPath;
+    /** The SMuFL fonts loaded so far (by path) */
+    static std::map<std::string, std::map<wchar_t, Glyph> > m_loadedFonts;
+    /** The parsed definitions of the SMuFL fonts, each Glyph pointing to its node */
+    static std::map<std::string, pugi::xml_document*> m_loadedFontDefinitions;
+    /** The combinations of SMuFL fonts built so far (by path and font names) */
+    static std::map<std::string, MapOfCodeGlyphs> m_fontSets;
+    /** The text fonts loaded so far (by path) */
+    static std::map<std::string, TextFont*> m_textFonts;
 };
 
 } // namespace vrv
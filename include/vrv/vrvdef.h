@@ -42,6 +42,7 @@ class Note;
 class Object;
 class Point;
 class Staff;
+class TimeSpanningInterface;
 
 typedef std::vector<Object*> ArrayOfObjects;
 
@@ -57,6 +58,10 @@ typedef std::vector<BeamElementCoord*> ArrayOfBeamElementCoords;
     
 typedef std::map<Staff*, std::vector<char> > MapOfLedgerLineFlags;
     
+typedef std::map<std::string, Object*> MapOfUuidObjects;
+    
+typedef std::map<std::string, std::vector<TimeSpanningInterface*> > MapOfUuidTimeSpanningInterfaces;
+    
 typedef std::vector<std::pair<LayerElement*, Point> > ArrayOfLayerElementPointPairs;
 
 //----------------------------------------------------------------------------
@@ -73,7 +78,6 @@ typedef std::vector<std::pair<LayerElement*, Point> > ArrayOfLayerElementPointPa
 enum ClassId {
     OBJECT = 0,
     //
-    ALIGNMENT,
     CLEF_ATTR,
     DOC,
     DOC_OBJECT,
@@ -54,6 +54,7 @@ FILES="../src/accid.cpp \
              ../src/staff.cpp \
              ../src/style.cpp \
              ../src/svgdevicecontext.cpp \
+             ../src/streamingsvgdevicecontext.cpp \
              ../src/syl.cpp \
              ../src/system.cpp \
              ../src/textdirective.cpp \
@@ -58,6 +58,7 @@ verovio_module = Extension('_verovio',
              '../src/staff.cpp',
              '../src/style.cpp',
              '../src/svgdevicecontext.cpp',
+             '../src/streamingsvgdevicecontext.cpp',
              '../src/syl.cpp',
              '../src/system.cpp',
              '../src/textdirective.cpp',
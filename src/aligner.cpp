@@ -134,64 +134,79 @@ MeasureAligner::MeasureAligner():
 
 MeasureAligner::~MeasureAligner()
 {
+    ArrayOfAlignments::iterator iter;
+    for (iter = m_alignments.begin(); iter != m_alignments.end(); ++iter) {
+        delete *iter;
+    }
+    for (iter = m_spareAlignments.begin(); iter != m_spareAlignments.end(); ++iter) {
+        delete *iter;
+    }
 }
 
 void MeasureAligner::Reset()
 {
+    // keep the alignments for re-using them - they are still owned by the MeasureAligner
+    m_spareAlignments.insert( m_spareAlignments.end(), m_alignments.begin(), m_alignments.end() );
+    m_alignments.clear();
+    m_nonJustifiedXRels.clear();
     Object::Reset();
-    m_leftAlignment = new Alignment( 0.0, ALIGNMENT_MEASURE_START );
+    m_leftAlignment = NewAlignment( 0.0, ALIGNMENT_MEASURE_START );
     AddAlignment( m_leftAlignment );
-    m_rightAlignment = new Alignment( 0.0, ALIGNMENT_MEASURE_END );
+    m_rightAlignment = NewAlignment( 0.0, ALIGNMENT_MEASURE_END );
     AddAlignment( m_rightAlignment );
 }
 
+Alignment *MeasureAligner::NewAlignment( double time, AlignmentType type )
+{
+    if ( m_spareAlignments.empty() ) {
+        return new Alignment( time, type );
+    }
+    Alignment *alignment = m_spareAlignments.back();
+    m_spareAlignments.pop_back();
+    alignment->ResetAlignment( time, type );
+    return alignment;
+}
+
 void MeasureAligner::AddAlignment( Alignment *alignment, int idx )
 {
-	alignment->SetParent( this );
     if ( idx == -1 ) {
-        m_children.push_back( alignment );
+        m_alignments.push_back( alignment );
     }
     else {
-        InsertChild( alignment, idx );
+        m_alignments.insert( m_alignments.begin() + idx, alignment );
     }
 }
 
 Alignment* MeasureAligner::GetAlignmentAtTime( double time, AlignmentType type, bool hasEndAlignment )
 {
-    int i;
-    int idx = -1; // the index if we reach the end.
-    Alignment *alignment = NULL;
-    // First try to see if we already have something at the time position
-    for (i = 0; i < GetAlignmentCount(); i++)
-    {
-        alignment = dynamic_cast<Alignment*>(m_children.at(i));
-        assert( alignment );
-        
-        double alignment_time = alignment->GetTime();
-        if ( vrv::AreEqual( alignment_time, time ) ) {
-            if (alignment->GetType() == type) {
-                return alignment;
-            }
-            else if ( alignment->GetType() > type ) {
-                idx = i;
-                break;
-            }
+    // The alignments are ordered by time and then by type, so we can look for the position with
+    // a binary search. This is tricky! Because we want m_rightAlignment to always stay at the end
+    // (with hasEndAlignment), it is not part of the search and we insert _before_ it at the most
+    // - m_rightAlignment is added in Reset() and its time is changed in SetMaxTime()
+    int first = 0;
+    int last = GetAlignmentCount();
+    if ( hasEndAlignment && ( last > 0 ) ) {
+        last--;
+    }
+    while ( first < last ) {
+        int middle = first + (last - first) / 2;
+        Alignment *alignment = m_alignments.at(middle);
+        if ( alignment->IsBefore( time, type ) ) {
+            first = middle + 1;
         }
-        // nothing found, do not go any further but keep the index
-        if (alignment->GetTime() > time) {
-            idx = i;
-            break;
+        else {
+            last = middle;
         }
     }
-    // nothing found
-    if ( idx == -1 ) {
-        // this is tricky! Because we want m_rightAlignment to always stay at the end (with hasEndAlignment),
-        // we always to insert _before_ the last one - m_rightAlignment is added in Reset()
-        if ( hasEndAlignment ) idx = GetAlignmentCount() - 1;
-        else idx = GetAlignmentCount();
+    // First try to see if we already have something at the time position
+    if ( first < GetAlignmentCount() ) {
+        Alignment *alignment = m_alignments.at(first);
+        if ( vrv::AreEqual( alignment->GetTime(), time ) && (alignment->GetType() == type) ) {
+            return alignment;
+        }
     }
-    Alignment *newAlignment = new Alignment( time, type );
-    AddAlignment( newAlignment, idx );
+    Alignment *newAlignment = NewAlignment( time, type );
+    AddAlignment( newAlignment, first );
     return newAlignment;
 }
 
@@ -243,8 +258,7 @@ void GraceAligner::AlignStack( )
 // Alignment
 //----------------------------------------------------------------------------
 
-Alignment::Alignment( ):
-    Object()
+Alignment::Alignment( )
 {
     m_xRel = 0;
     m_xShift = 0;
@@ -254,8 +268,7 @@ Alignment::Alignment( ):
     m_graceAligner = NULL;
 }
 
-Alignment::Alignment( double time, AlignmentType type ):
-    Object()
+Alignment::Alignment( double time, AlignmentType type )
 {
     m_xRel = 0;
     m_xShift = 0;
@@ -273,6 +286,19 @@ Alignment::~Alignment()
     
 }
 
+void Alignment::ResetAlignment( double time, AlignmentType type )
+{
+    m_xRel = 0;
+    m_xShift = 0;
+    m_maxWidth = 0;
+    m_time = time;
+    m_type = type;
+    if (m_graceAligner) {
+        delete m_graceAligner;
+        m_graceAligner = NULL;
+    }
+}
+
 void Alignment::SetXRel( int x_rel )
 {
     m_xRel = x_rel;
@@ -292,6 +318,14 @@ void Alignment::SetMaxWidth( int maxWidth )
     }
 }
     
+bool Alignment::IsBefore( double time, AlignmentType type )
+{
+    if ( vrv::AreEqual( m_time, time ) ) {
+        return ( m_type < type );
+    }
+    return ( m_time < time );
+}
+    
 GraceAligner *Alignment::GetGraceAligner( )
 {
     if (!m_graceAligner) {
@@ -364,41 +398,55 @@ int MeasureAligner::IntegrateBoundingBoxXShift( ArrayPtrVoid *params )
     (*shift) = doc->GetLeftPosition() * doc->GetDrawingUnit(100) / PARAM_DENOMINATOR;;
     (*justifiable_shift) = -1;
     
+    ArrayOfAlignments::iterator iter;
+    for (iter = m_alignments.begin(); iter != m_alignments.end(); ++iter) {
+        (*iter)->IntegrateBoundingBoxXShift( params, this );
+    }
+    
+    return FUNCTOR_CONTINUE;
+}
+    
+int MeasureAligner::IntegrateBoundingBoxGraceXShift( ArrayPtrVoid *params )
+{
+    // param 0: the functor to be redirected to the MeasureAligner (unused)
+    
+    ArrayOfAlignments::iterator iter;
+    for (iter = m_alignments.begin(); iter != m_alignments.end(); ++iter) {
+        (*iter)->IntegrateBoundingBoxGraceXShift( );
+    }
+    
     return FUNCTOR_CONTINUE;
 }
     
-int Alignment::IntegrateBoundingBoxGraceXShift( ArrayPtrVoid *params )
+void Alignment::IntegrateBoundingBoxGraceXShift( )
 {
     if (!m_graceAligner) {
-        return FUNCTOR_CONTINUE;
+        return;
     }
     
     int i;
     int shift = 0;
-    for (i = 0; i < (int)m_graceAligner->m_children.size(); i++) {
-        Alignment *alignment = dynamic_cast<Alignment*>(m_graceAligner->m_children.at(i));
-        assert( alignment );
+    for (i = 0; i < m_graceAligner->GetAlignmentCount(); i++) {
+        Alignment *alignment = m_graceAligner->GetAlignmentAt(i);
         alignment->SetXRel( alignment->GetXShift() + shift );
         shift += alignment->GetXShift();
     }
     
     // Set the total width by looking at the position and maximum width of the last alignment
-    if ( m_graceAligner->m_children.empty() ) {
-        return FUNCTOR_CONTINUE;
+    if ( m_graceAligner->GetAlignmentCount() == 0 ) {
+        return;
     }
-    Alignment *alignment = dynamic_cast<Alignment*>(m_graceAligner->m_children.back());
-    assert( alignment );
+    Alignment *alignment = m_graceAligner->GetAlignmentAt( m_graceAligner->GetAlignmentCount() - 1 );
     m_graceAligner->SetWidth( alignment->GetXRel() + alignment->GetMaxWidth() );
-    
-    return FUNCTOR_CONTINUE;
 }
 
-int Alignment::IntegrateBoundingBoxXShift( ArrayPtrVoid *params )
+void Alignment::IntegrateBoundingBoxXShift( ArrayPtrVoid *params, MeasureAligner *aligner )
 {
     // param 0: the accumulated shift
     // param 1: the accumulated justifiable shift
     // param 2: the minimum measure with
-    // param 3: the functor to be redirected to the MeasureAligner (unused)
+    // param 3: the doc for accessing drawing parameters (unused)
+    // param 4: the functor to be redirected to the MeasureAligner (unused)
     int *shift = static_cast<int*>((*params).at(0));
     int *justifiable_shift = static_cast<int*>((*params).at(1));
     int *minMeasureWidth = static_cast<int*>((*params).at(2));
@@ -408,14 +456,11 @@ int Alignment::IntegrateBoundingBoxXShift( ArrayPtrVoid *params )
     // cumulate the shift value and the width
     (*shift) += m_xShift;
 
+    assert( aligner );
     if ((GetType() <= ALIGNMENT_METERSIG_ATTR) && ((*justifiable_shift) < 0)) {
-        MeasureAligner *aligner = dynamic_cast<MeasureAligner*>(m_parent);
-        assert( aligner );
         aligner->SetNonJustifiableMargin(this->m_xRel + this->m_maxWidth);
     }
     else if ((GetType() > ALIGNMENT_METERSIG_ATTR) && ((*justifiable_shift) < 0)) {
-        MeasureAligner *aligner = dynamic_cast<MeasureAligner*>(m_parent);
-        assert( aligner );
         (*justifiable_shift) = aligner->GetNonJustifiableMargin();
     }
 
@@ -428,8 +473,6 @@ int Alignment::IntegrateBoundingBoxXShift( ArrayPtrVoid *params )
 
     // reset member to 0
     m_xShift = 0;
-    
-    return FUNCTOR_CONTINUE;
 }
 
 int MeasureAligner::SetAlignmentXPos( ArrayPtrVoid *params )
@@ -447,6 +490,11 @@ int MeasureAligner::SetAlignmentXPos( ArrayPtrVoid *params )
     (*previousTime) = 0.0;
     (*previousXRel) = 0;
     
+    ArrayOfAlignments::iterator iter;
+    for (iter = m_alignments.begin(); iter != m_alignments.end(); ++iter) {
+        (*iter)->SetAlignmentXPos( params );
+    }
+    
     return FUNCTOR_CONTINUE;
 }
 
@@ -470,7 +518,7 @@ int Alignment::HorizontalSpaceForDuration(double intervalTime, int maxActualDur,
     return intervalXRel;
 }
 
-int Alignment::SetAlignmentXPos( ArrayPtrVoid *params )
+void Alignment::SetAlignmentXPos( ArrayPtrVoid *params )
 {
     // param 0: the previous time position
     // param 1: the previous x rel position
@@ -491,8 +539,6 @@ int Alignment::SetAlignmentXPos( ArrayPtrVoid *params )
     m_xRel = (*previousXRel) + (intervalXRel) * DEFINITON_FACTOR;
     (*previousTime) = m_time;
     (*previousXRel) = m_xRel;
-    
-    return FUNCTOR_CONTINUE;
 }
     
 int MeasureAligner::JustifyX( ArrayPtrVoid *params )
@@ -506,6 +552,13 @@ int MeasureAligner::JustifyX( ArrayPtrVoid *params )
     double *measureRatio =static_cast<double*>((*params).at(1));
     int *margin =static_cast<int*>((*params).at(2));
     
+    // keep the positions for being able to justify the measure again
+    m_nonJustifiedXRels.resize( m_alignments.size() );
+    int i;
+    for (i = 0; i < (int)m_alignments.size(); i++) {
+        m_nonJustifiedXRels.at(i) = m_alignments.at(i)->GetXRel();
+    }
+    
     int width = GetRightAlignment()->GetXRel() + GetRightAlignment()->GetMaxWidth();
     
     // the ratio in the measure has to take into account the non justifiable width
@@ -517,11 +570,41 @@ int MeasureAligner::JustifyX( ArrayPtrVoid *params )
     (*measureRatio) = ((*ratio) - 1) * ((double)m_nonJustifiableLeftMargin / (double)width) + (*ratio);
     (*margin) = m_nonJustifiableLeftMargin;
     
+    ArrayOfAlignments::iterator iter;
+    for (iter = m_alignments.begin(); iter != m_alignments.end(); ++iter) {
+        (*iter)->JustifyX( params );
+    }
+    
     return FUNCTOR_CONTINUE;
 }
 
+void MeasureAligner::ResetJustification( )
+{
+    if ( m_nonJustifiedXRels.empty() ) {
+        return;
+    }
+    
+    assert( m_nonJustifiedXRels.size() == m_alignments.size() );
+    
+    int i;
+    for (i = 0; i < (int)m_alignments.size(); i++) {
+        m_alignments.at(i)->SetXRel( m_nonJustifiedXRels.at(i) );
+    }
+    m_nonJustifiedXRels.clear();
+}
+    
+int MeasureAligner::GetNonJustifiedRightXRel( )
+{
+    assert( m_rightAlignment );
+    
+    // the right alignment is always the last one
+    if ( !m_nonJustifiedXRels.empty() ) {
+        return m_nonJustifiedXRels.back();
+    }
+    return m_rightAlignment->GetXRel();
+}
 
-int Alignment::JustifyX( ArrayPtrVoid *params )
+void Alignment::JustifyX( ArrayPtrVoid *params )
 {
     // param 0: the justification ratio
     // param 1: the justification ratio for the measure (depends on the margin)
@@ -533,11 +616,11 @@ int Alignment::JustifyX( ArrayPtrVoid *params )
     int *margin =static_cast<int*>((*params).at(2));
     
     if (GetType() == ALIGNMENT_MEASURE_START) {
-        return FUNCTOR_CONTINUE;
+        return;
     }
     else if (GetType() == ALIGNMENT_MEASURE_END) {
         this->m_xRel = ceil((*ratio) * (double)this->m_xRel);
-        return FUNCTOR_CONTINUE;
+        return;
     }
     
     // the ratio in the measure has to take into account the non justifiable width
@@ -549,8 +632,6 @@ int Alignment::JustifyX( ArrayPtrVoid *params )
     if ((GetType() < ALIGNMENT_CLEF_ATTR) || (GetType() > ALIGNMENT_METERSIG_ATTR)) {
         this->m_xRel = ceil(((double)this->m_xRel - (double)(*margin)) * (*measureRatio)) + (*margin);
     }
-
-    return FUNCTOR_CONTINUE;
 }
     
 } // namespace vrv
@@ -335,7 +335,7 @@ void BBoxDeviceContext::DrawMusicText(const std::wstring& text, int x, int y)
     for (unsigned int i = 0; i < text.length(); i++)
     {
         wchar_t c = text[i];
-        Glyph *glyph = Resources::GetGlyph(c);
+        Glyph *glyph = GetResources()->GetGlyph(c);
         if (!glyph) {
             continue;
         }
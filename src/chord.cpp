@@ -290,6 +290,7 @@ int Chord::PrepareTieAttr( ArrayPtrVoid *params )
 {
     // param 0: std::vector<Note*>* that holds the current notes with open ties (unused)
     // param 1: Chord** currentChord for the current chord if in a chord
+    // param 2: std::vector<std::string>* for the warnings (unused)
     Chord **currentChord = static_cast<Chord**>((*params).at(1));
     
     assert(!(*currentChord));
@@ -302,6 +303,7 @@ int Chord::PrepareTieAttrEnd( ArrayPtrVoid *params )
 {
     // param 0: std::vector<Note*>* that holds the current notes with open ties (unused)
     // param 1: Chord** currentChord for the current chord if in a chord
+    // param 2: std::vector<std::string>* for the warnings (unused)
     Chord **currentChord = static_cast<Chord**>((*params).at(1));
     
     assert((*currentChord));
@@ -108,12 +108,12 @@ void DeviceContext::GetTextExtent( const std::wstring& string, int *w, int *h )
     (*w) = 0;
     (*h) = 0;
     
-    Glyph *unkown = Resources::GetTextGlyph(L'o');
+    Glyph *unkown = GetResources()->GetTextGlyph(L'o');
     
     for (unsigned int i = 0; i < string.length(); i++)
     {
         wchar_t c = string[i];
-        Glyph *glyph = Resources::GetTextGlyph(c);
+        Glyph *glyph = GetResources()->GetTextGlyph(c);
         if (!glyph) {
             glyph = unkown;
         }
@@ -140,7 +140,7 @@ void DeviceContext::GetSmuflTextExtent( const std::wstring& string, int *w, int
     for (unsigned int i = 0; i < string.length(); i++)
     {
         wchar_t c = string[i];
-        Glyph *glyph = Resources::GetGlyph(c);
+        Glyph *glyph = GetResources()->GetGlyph(c);
         if (!glyph) {
             continue;
         }
@@ -10,8 +10,11 @@
 
 //----------------------------------------------------------------------------
 
+#include <algorithm>
 #include <assert.h>
+#include <cstdlib>
 #include <math.h>
+#include <pthread.h>
 
 //----------------------------------------------------------------------------
 
@@ -21,6 +24,7 @@
 #include "glyph.h"
 #include "keysig.h"
 #include "layer.h"
+#include "measure.h"
 #include "mensur.h"
 #include "metersig.h"
 #include "mrest.h"
@@ -38,6 +42,31 @@
 
 namespace vrv {
 
+// The ranges of the uuid sequence reserved for the staves in PrepareDrawing (see Doc::m_staffUuidGenerators),
+// in the second half of the sequence of the document, with up to 16M uuids for each staff
+#define STAFF_UUID_FIRST 0x80000000U
+#define STAFF_UUID_RANGES 128
+#define STAFF_UUID_RANGE_SIZE 0x1000000U
+
+//----------------------------------------------------------------------------
+// PrepareByLayerJob
+//----------------------------------------------------------------------------
+
+/**
+ * The staves to be processed by Doc::ProcessLayerStates, shared by the worker threads.
+ */
+struct PrepareByLayerJob {
+    /** The document being prepared */
+    Doc *m_doc;
+    /** The staff/layer states, with one map per staff */
+    std::vector<MapOfPrepareLayerStates> *m_layerStates;
+    /** The staves of each staff, in the same order as m_layerStates */
+    std::vector<ArrayOfObjects*> m_staffLists;
+    /** The next staff to be processed (index in m_layerStates) - locked with m_mutex */
+    int m_nextStaff;
+    pthread_mutex_t m_mutex;
+};
+
 //----------------------------------------------------------------------------
 // Doc
 //----------------------------------------------------------------------------
@@ -46,18 +75,32 @@ Doc::Doc() :
     Object("doc-")
 {
     m_style = new Style();
+    m_castOffContentSystem = NULL;
+    m_uuidGenerator.Seed( (unsigned int)std::rand() );
     Reset( Raw );
 }
 
 Doc::~Doc()
 {
+    // the objects do not need to be removed one by one from the index
+    ResetUuidIndex();
+    // delete the objects now because the arena is deleted before Object::~Object is called
+    ClearChildren();
+    delete m_castOffContentSystem;
+    m_scoreDef.Reset();
     delete m_style;
-    
 }
 
 void Doc::Reset( DocType type )
 {
+    // before deleting the objects, which do not need to be removed one by one from the index
+    ResetUuidIndex();
     Object::Reset();
+    // the content kept aside by a progressive cast off
+    if ( m_castOffContentSystem ) {
+        delete m_castOffContentSystem;
+        m_castOffContentSystem = NULL;
+    }
     
     m_type = type;
     m_pageWidth = -1;
@@ -68,6 +111,7 @@ void Doc::Reset( DocType type )
     
     m_drawingSpacingLinear = DEFAULT_SPACING_LINEAR;
     m_drawingSpacingNonLinear = DEFAULT_SPACING_NON_LINEAR;
+    m_prepareDrawingThreads = 1;
     
     m_spacingStaff = m_style->m_spacingStaff;
     m_spacingSystem = m_style->m_spacingSystem;
@@ -77,8 +121,20 @@ void Doc::Reset( DocType type )
     m_drawingEvenSpacing = false;
     m_currentScoreDefDone = false;
     m_drawingPreparationDone = false;
+    m_castOffLayoutDone = false;
+    m_castOffReuseLayout = false;
+    
+    // restart the sequence of uuids, including the ones of the document and of its scoreDef
+    // for the ids to be the same as with a new document when the document is re-used
+    m_uuidGenerator.Seed( m_uuidGenerator.GetSeed() );
+    m_staffUuidGenerators.clear();
+    UuidGeneratorScope uuidScope( &m_uuidGenerator );
+    this->ResetUuid();
+    m_scoreDef.ResetUuid();
     
     m_scoreDef.Reset();
+    // all the objects have been deleted, the memory can be released
+    m_objectArena.Release();
     
     m_drawingSmuflFontSize = 0;
     m_drawingLyricFontSize = 0;
@@ -92,6 +148,71 @@ void Doc::AddPage( Page *page )
     Modify();
 }
 
+Object *Doc::FindObjectByUuid( const std::string &uuid )
+{
+    if ( !m_uuidIndexDone ) {
+        m_uuidIndex.clear();
+        m_uuidIndexDone = true;
+        AddToUuidIndex( this );
+    }
+    
+    // all the objects attached to the document are in the index
+    MapOfUuidObjects::iterator iter = m_uuidIndex.find( uuid );
+    return ( iter != m_uuidIndex.end() ) ? iter->second : NULL;
+}
+    
+void Doc::AddToUuidIndex( Object *object, int deepness )
+{
+    assert( object );
+    
+    if ( !m_uuidIndexDone ) {
+        return;
+    }
+    
+    bool add = true;
+    ArrayPtrVoid params;
+    params.push_back( &m_uuidIndex );
+    params.push_back( &add );
+    params.push_back( this );
+    Functor updateUuidIndex( &Object::UpdateUuidIndex );
+    object->Process( &updateUuidIndex, &params, NULL, NULL, deepness );
+}
+    
+void Doc::RemoveFromUuidIndex( Object *object, int deepness )
+{
+    assert( object );
+    
+    if ( !m_uuidIndexDone ) {
+        return;
+    }
+    
+    bool add = false;
+    ArrayPtrVoid params;
+    params.push_back( &m_uuidIndex );
+    params.push_back( &add );
+    params.push_back( this );
+    Functor updateUuidIndex( &Object::UpdateUuidIndex );
+    object->Process( &updateUuidIndex, &params, NULL, NULL, deepness );
+}
+    
+void Doc::RemoveFromUuidIndex( const std::string &uuid, Object *object )
+{
+    if ( !m_uuidIndexDone ) {
+        return;
+    }
+    
+    MapOfUuidObjects::iterator iter = m_uuidIndex.find( uuid );
+    if ( ( iter != m_uuidIndex.end() ) && ( iter->second == object ) ) {
+        m_uuidIndex.erase( iter );
+    }
+}
+    
+void Doc::ResetUuidIndex( )
+{
+    m_uuidIndex.clear();
+    m_uuidIndexDone = false;
+}
+    
 void Doc::Refresh()
 {
     RefreshViews();
@@ -101,32 +222,52 @@ void Doc::PrepareDrawing()
 {
     ArrayPtrVoid params;
     
+    // the drawing objects (e.g., the ties of the notes) get their uuid from the document
+    UuidGeneratorScope uuidScope( &m_uuidGenerator );
+    
+    // the layout of the document will change
+    this->ResetCastOffLayout();
+    
     if (m_drawingPreparationDone) {
         Functor resetDrawing( &Object::ResetDrawing );
         this->Process( &resetDrawing, &params );
     }
     
     // Try to match all spanning elements (slur, tie, etc) by processing backward
+    // The elements still to be matched are looked for by start and end uuid
     std::vector<DocObject*> timeSpanningElements;
     bool fillList = true;
+    MapOfUuidTimeSpanningInterfaces timeSpanningStarts;
+    MapOfUuidTimeSpanningInterfaces timeSpanningEnds;
     params.push_back( &timeSpanningElements );
     params.push_back( &fillList );
+    params.push_back( &timeSpanningStarts );
+    params.push_back( &timeSpanningEnds );
     Functor prepareTimeSpanning( &Object::PrepareTimeSpanning );
     this->Process( &prepareTimeSpanning, &params, NULL, NULL, UNLIMITED_DEPTH, BACKWARD );
     
     // First we tried backward because normally the spanning elements are at the end of
     // the measure. However, in some case, one (or both) end points will appear afterwards
     // in the encoding. For these, the previous iteration will not have resolved the link and
-    // the spanning elements will remain in the timeSpanningElements array. We try again forward
+    // the spanning elements will remain in the maps. We try again forward
     // but this time without filling the list (that is only will the remaining elements)
-    if ( !timeSpanningElements.empty() ) {
+    if ( !timeSpanningStarts.empty() || !timeSpanningEnds.empty() ) {
         fillList = false;
         this->Process( &prepareTimeSpanning, &params );
     }
     
-    // If some are still there, then it is probably an issue in the encoding
-    if ( !timeSpanningElements.empty() ) {
-        LogWarning("%d time spanning elements could not be matched", timeSpanningElements.size() );
+    // If some are still not matched, then it is probably an issue in the encoding
+    int unmatched = 0;
+    std::vector<DocObject*>::iterator timeSpanningIter;
+    for (timeSpanningIter = timeSpanningElements.begin(); timeSpanningIter != timeSpanningElements.end(); ++timeSpanningIter) {
+        TimeSpanningInterface *interface = dynamic_cast<TimeSpanningInterface*>(*timeSpanningIter);
+        assert( interface );
+        if ( !interface->HasStartAndEnd() ) {
+            unmatched++;
+        }
+    }
+    if ( unmatched > 0 ) {
+        LogWarning("%d time spanning elements could not be matched", unmatched );
     }
     
     // We need to populate processing lists for processing the document by Layer (for matching @tie) and
@@ -145,95 +286,136 @@ void Doc::PrepareDrawing()
     Functor prepareProcessingLists( &Object::PrepareProcessingLists );
     this->Process( &prepareProcessingLists, &params );
     
-    // The tree is used to process each staff/layer/verse separatly
-    // For this, we use a array of AttCommmonNComparison that looks for each object if it is of the type
-    // and with @n specified
+    // The trees are used to create a state for each staff/layer, with the verses for the lyrics.
+    // The document is then processed only once, each element being dispatched to the state of its
+    // staff/layer (see Object::PrepareByLayer), instead of once for each staff/layer/verse.
+    // With more than one thread, we have one map per staff and the staves are processed concurrently
+    bool concurrent = ( m_prepareDrawingThreads > 1 ) && ( layerTree.child.size() > 1 );
+    std::vector<MapOfPrepareLayerStates> layerStates( concurrent ? layerTree.child.size() : 1 );
     
     IntTree_t::iterator staves;
     IntTree_t::iterator layers;
     IntTree_t::iterator verses;
+    IntTree_t::iterator verseStaves;
+    IntTree_t::iterator verseLayers;
     
-    // Process by layer for matching @tie attribute - we process notes and chords, looking at
-    // GetTie values and pitch and oct for matching notes
-    Chord *currentChord;
-    std::vector<Note*> currentNotes;
-    std::vector<AttComparison*> filters;
+    int staffIdx = 0;
     for (staves = layerTree.child.begin(); staves != layerTree.child.end(); ++staves) {
+        // The range of uuids of the staff is kept from one call to the other for the uuids to remain unique
+        if ( m_staffUuidGenerators.find( staves->first ) == m_staffUuidGenerators.end() ) {
+            unsigned int range = (unsigned int)staves->first % STAFF_UUID_RANGES;
+            m_staffUuidGenerators[ staves->first ].Derive( &m_uuidGenerator, STAFF_UUID_FIRST + range * STAFF_UUID_RANGE_SIZE );
+        }
+        MapOfPrepareLayerStates &staffStates = layerStates.at( staffIdx );
+        verseStaves = verseTree.child.find( staves->first );
         for (layers = staves->second.child.begin(); layers != staves->second.child.end(); ++layers) {
-            filters.clear();
-            // Create ad comparison object for each type / @n
-            AttCommonNComparison matchStaff( STAFF, staves->first );
-            AttCommonNComparison matchLayer( LAYER, layers->first );
-            filters.push_back( &matchStaff );
-            filters.push_back( &matchLayer );
+            // The params point to the state members, so they can be filled only once the state is in the map
+            PrepareLayerState &state = staffStates[ std::make_pair( staves->first, layers->first ) ];
+            // For matching @tie attribute - we process notes and chords, looking at
+            // GetTie values and pitch and oct for matching notes
+            state.m_currentChord = NULL;
+            state.m_tieAttrParams.push_back( &state.m_currentNotes );
+            state.m_tieAttrParams.push_back( &state.m_currentChord );
+            state.m_tieAttrParams.push_back( &state.m_warnings );
+            state.m_currentNote = NULL;
+            state.m_pointersParams.push_back( &state.m_currentNote );
+            state.m_lastNote = NULL;
+            state.m_lastButOneNote = NULL;
+            // For matching mRpt elements and setting the drawing number
+            state.m_currentMRpt = NULL;
+            // We set multiNumber to NONE for indicated we need to look at the staffDef when reaching the first staff
+            state.m_multiNumber = BOOLEAN_NONE;
+            state.m_rptParams.push_back( &state.m_currentMRpt );
+            state.m_rptParams.push_back( &state.m_multiNumber );
+            state.m_rptParams.push_back( &m_scoreDef );
             
-            currentChord = NULL;
-            currentNotes.clear();
-            ArrayPtrVoid paramsTieAttr;
-            paramsTieAttr.push_back( &currentNotes );
-            paramsTieAttr.push_back( &currentChord );
-            Functor prepareTieAttr( &Object::PrepareTieAttr );
-            Functor prepareTieAttrEnd( &Object::PrepareTieAttrEnd );
-            this->Process( &prepareTieAttr, &paramsTieAttr, &prepareTieAttrEnd, &filters );
-        
-            // After having processed one layer, we check if we have open ties - if yes, we
-            // must reset them and they will be ignored.
-            if ( !currentNotes.empty() ) {
-                std::vector<Note*>::iterator iter;
-                for (iter = currentNotes.begin(); iter != currentNotes.end(); iter++) {
-                    LogWarning("Unable to match @tie of note '%s', skipping it", (*iter)->GetUuid().c_str());
-                    (*iter)->ResetDrawingTieAttr();
-                }
+            // Same for the lyrics, but Verse by Verse since Syl are TimeSpanningInterface elements for handling connectors
+            if ( verseStaves == verseTree.child.end() ) {
+                continue;
             }
+            verseLayers = verseStaves->second.child.find( layers->first );
+            if ( verseLayers == verseStaves->second.child.end() ) {
+                continue;
+            }
+            for (verses = verseLayers->second.child.begin(); verses != verseLayers->second.child.end(); ++verses) {
+                // The first pass set m_drawingFirstNote and m_drawingLastNote for each syl
+                // m_drawingLastNote is set only if the syl has a forward connector
+                state.m_currentSyls[ verses->first ] = NULL;
+                ArrayPtrVoid &lyricsParams = state.m_lyricsParams[ verses->first ];
+                lyricsParams.push_back( &state.m_currentSyls[ verses->first ] );
+                lyricsParams.push_back( &state.m_lastNote );
+                lyricsParams.push_back( &state.m_lastButOneNote );
+            }
+        }
+        if ( concurrent ) {
+            staffIdx++;
         }
     }
     
-    Note *currentNote = NULL;
-    for (staves = layerTree.child.begin(); staves != layerTree.child.end(); ++staves) {
-        for (layers = staves->second.child.begin(); layers != staves->second.child.end(); ++layers) {
-            filters.clear();
-            // Create ad comparison object for each type / @n
-            AttCommonNComparison matchStaff( STAFF, staves->first );
-            AttCommonNComparison matchLayer( LAYER, layers->first );
-            filters.push_back( &matchStaff );
-            filters.push_back( &matchLayer );
-
-            ArrayPtrVoid paramsPointers;
-            paramsPointers.push_back( &currentNote );
-            Functor preparePointersByLayer( &Object::PreparePointersByLayer );
-            this->Process( &preparePointersByLayer, &paramsPointers, NULL, &filters );
+    if ( !concurrent ) {
+        this->ProcessLayerStates( &layerStates.at( 0 ), NULL );
+    }
+    else {
+        // The staffDefs are looked for in Staff::PrepareRpt - make sure the list will not be modified by the threads
+        m_scoreDef.ResetList( &m_scoreDef );
+        
+        // Each thread processes only the staves of the staff it takes instead of walking the whole document
+        std::map<int, ArrayOfObjects> staffLists;
+        params.clear();
+        params.push_back( &staffLists );
+        Functor prepareStaffLists( &Object::PrepareStaffLists );
+        this->Process( &prepareStaffLists, &params );
+        
+        PrepareByLayerJob job;
+        job.m_doc = this;
+        job.m_layerStates = &layerStates;
+        for (staves = layerTree.child.begin(); staves != layerTree.child.end(); ++staves) {
+            job.m_staffLists.push_back( &staffLists[ staves->first ] );
+        }
+        job.m_nextStaff = 0;
+        pthread_mutex_init( &job.m_mutex, NULL );
+        
+        int threads = std::min( m_prepareDrawingThreads, (int)layerStates.size() );
+        std::vector<pthread_t> workers;
+        int i;
+        for (i = 1; i < threads; i++) {
+            pthread_t worker;
+            // If the thread cannot be created, the staves will be processed by the others
+            if ( pthread_create( &worker, NULL, PrepareByLayerWorker, &job ) == 0 ) {
+                workers.push_back( worker );
+            }
+        }
+        
+        ProcessLayerStatesJob( &job );
+        
+        std::vector<pthread_t>::iterator workerIter;
+        for (workerIter = workers.begin(); workerIter != workers.end(); ++workerIter) {
+            pthread_join( *workerIter, NULL );
         }
+        pthread_mutex_destroy( &job.m_mutex );
     }
     
-    // Same for the lyrics, but Verse by Verse since Syl are TimeSpanningInterface elements for handling connectors
-    Syl *currentSyl;
-    Note *lastNote;
-    Note *lastButOneNote;
-    for (staves = verseTree.child.begin(); staves != verseTree.child.end(); ++staves) {
-        for (layers = staves->second.child.begin(); layers != staves->second.child.end(); ++layers) {
-            for (verses= layers->second.child.begin(); verses != layers->second.child.end(); ++verses) {
-                //std::cout << staves->first << " => " << layers->first << " => " << verses->first << '\n';
-                filters.clear();
-                // Create ad comparison object for each type / @n
-                AttCommonNComparison matchStaff( STAFF, staves->first );
-                AttCommonNComparison matchLayer( LAYER, layers->first );
-                AttCommonNComparison matchVerse( VERSE, verses->first );
-                filters.push_back( &matchStaff );
-                filters.push_back( &matchLayer );
-                filters.push_back( &matchVerse );
-                
-                // The first pass set m_drawingFirstNote and m_drawingLastNote for each syl
-                // m_drawingLastNote is set only if the syl has a forward connector
-                currentSyl = NULL;
-                lastNote = NULL;
-                lastButOneNote = NULL;
-                ArrayPtrVoid paramsLyrics;
-                paramsLyrics.push_back( &currentSyl );
-                paramsLyrics.push_back( &lastNote );
-                paramsLyrics.push_back( &lastButOneNote );
-                Functor prepareLyrics( &Object::PrepareLyrics );
-                Functor prepareLyricsEnd( &Object::PrepareLyricsEnd );
-                this->Process( &prepareLyrics, &paramsLyrics, &prepareLyricsEnd, &filters );
+    // The warnings are logged here by staff/layer for their order not to depend on the threads
+    std::vector<MapOfPrepareLayerStates>::iterator staffStatesIter;
+    MapOfPrepareLayerStates::iterator layerStateIter;
+    for (staffStatesIter = layerStates.begin(); staffStatesIter != layerStates.end(); ++staffStatesIter) {
+        for (layerStateIter = staffStatesIter->begin(); layerStateIter != staffStatesIter->end(); ++layerStateIter) {
+            PrepareLayerState &state = layerStateIter->second;
+            std::vector<std::string>::iterator warningIter;
+            for (warningIter = state.m_warnings.begin(); warningIter != state.m_warnings.end(); ++warningIter) {
+                LogWarning( "%s", warningIter->c_str() );
+            }
+            // After having processed one layer, we check if we have open ties - if yes, we
+            // must reset them and they will be ignored.
+            std::vector<Note*>::iterator iter;
+            for (iter = state.m_currentNotes.begin(); iter != state.m_currentNotes.end(); iter++) {
+                LogWarning("Unable to match @tie of note '%s', skipping it", (*iter)->GetUuid().c_str());
+                (*iter)->ResetDrawingTieAttr();
+            }
+            // Close the syl still open at the end of each verse
+            std::map<int, ArrayPtrVoid>::iterator lyricsIter;
+            for (lyricsIter = state.m_lyricsParams.begin(); lyricsIter != state.m_lyricsParams.end(); ++lyricsIter) {
+                this->PrepareLyricsEnd( &lyricsIter->second );
             }
         }
     }
@@ -252,32 +434,6 @@ void Doc::PrepareDrawing()
         LogDebug("%d time spanning elements could not be set as running", timeSpanningElements.size() );
     }
     
-    // Process by staff for matching mRpt elements and setting the drawing number
-    MRpt *currentMRpt;
-    data_BOOLEAN multiNumber;
-    for (staves = layerTree.child.begin(); staves != layerTree.child.end(); ++staves) {
-        for (layers = staves->second.child.begin(); layers != staves->second.child.end(); ++layers) {
-            filters.clear();
-            // Create ad comparison object for each type / @n
-            AttCommonNComparison matchStaff( STAFF, staves->first );
-            AttCommonNComparison matchLayer( LAYER, layers->first );
-            filters.push_back( &matchStaff );
-            filters.push_back( &matchLayer );
-            
-            // The first pass set m_drawingFirstNote and m_drawingLastNote for each syl
-            // m_drawingLastNote is set only if the syl has a forward connector
-            currentMRpt = NULL;
-            // We set multiNumber to NONE for indicated we need to look at the staffDef when reaching the first staff
-            multiNumber = BOOLEAN_NONE;
-            ArrayPtrVoid paramsRptAttr;
-            paramsRptAttr.push_back(&currentMRpt);
-            paramsRptAttr.push_back(&multiNumber);
-            paramsRptAttr.push_back(&m_scoreDef);
-            Functor prepareRpt( &Object::PrepareRpt );
-            this->Process( &prepareRpt, &paramsRptAttr, NULL, &filters );
-        }
-    }
-    
     /*
     // Alternate solution with StaffN_LayerN_VerseN_t
     StaffN_LayerN_VerseN_t::iterator staves;
@@ -309,12 +465,61 @@ void Doc::PrepareDrawing()
     m_drawingPreparationDone = true;
 }
     
+void Doc::ProcessLayerStates( MapOfPrepareLayerStates *layerStates, ArrayOfObjects *staves )
+{
+    ArrayPtrVoid params;
+    PrepareLayerState *currentState = NULL;
+    Staff *currentStaff = NULL;
+    ArrayPtrVoid *currentLyricsParams = NULL;
+    params.push_back( layerStates );
+    params.push_back( &currentState );
+    params.push_back( &currentStaff );
+    params.push_back( &currentLyricsParams );
+    params.push_back( &m_staffUuidGenerators );
+    Functor prepareByLayer( &Object::PrepareByLayer );
+    Functor prepareByLayerEnd( &Object::PrepareByLayerEnd );
+    // Staff::PrepareByLayer sets the generator of each staff as the current one - restore it afterwards
+    UuidGeneratorScope uuidScope( UuidGenerator::GetCurrent() );
+    if ( !staves ) {
+        this->Process( &prepareByLayer, &params, &prepareByLayerEnd );
+        return;
+    }
+    ArrayOfObjects::iterator iter;
+    for (iter = staves->begin(); iter != staves->end(); ++iter) {
+        (*iter)->Process( &prepareByLayer, &params, &prepareByLayerEnd );
+    }
+}
+    
+void Doc::ProcessLayerStatesJob( PrepareByLayerJob *job )
+{
+    while ( true ) {
+        pthread_mutex_lock( &job->m_mutex );
+        int staffIdx = job->m_nextStaff++;
+        pthread_mutex_unlock( &job->m_mutex );
+        
+        if ( staffIdx >= (int)job->m_layerStates->size() ) {
+            break;
+        }
+        // each staff is modified by one thread only
+        job->m_doc->ProcessLayerStates( &job->m_layerStates->at( staffIdx ), job->m_staffLists.at( staffIdx ) );
+    }
+}
+    
+void *Doc::PrepareByLayerWorker( void *param )
+{
+    PrepareByLayerJob *job = static_cast<PrepareByLayerJob*>( param );
+    UuidGeneratorScope uuidScope( &job->m_doc->m_uuidGenerator );
+    ProcessLayerStatesJob( job );
+    return NULL;
+}
+    
 void Doc::SetCurrentScoreDef( bool force )
 {
     if ( m_currentScoreDefDone && !force ) {
         return;
     }
     
+    UuidGeneratorScope uuidScope( &m_uuidGenerator );
     ScoreDef currentScoreDef;
     currentScoreDef = m_scoreDef;
     StaffDef *staffDef = NULL;
@@ -334,43 +539,194 @@ void Doc::SetCurrentScoreDef( bool force )
     m_currentScoreDefDone = true;
 }
 
-void Doc::CastOff( )
+void Doc::CastOff( bool progressive )
 {
+    // A cast off in progress is undone first
+    if ( m_castOffContentSystem ) {
+        this->UnCastOff();
+    }
+    
     this->SetCurrentScoreDef();
     
     Page *contentPage = this->SetDrawingPage( 0 );
     assert( contentPage );
-    contentPage->LayOutHorizontally();
     
-    System *contentSystem = dynamic_cast<System*>(contentPage->DetachChild( 0 ));
+    System *contentSystem = dynamic_cast<System*>(contentPage->GetChild( 0 ));
     assert( contentSystem );
     
+    // The measures within editorial markup cannot be looked for, so we always lay them out in that case
+    bool hasEditorialElement = false;
+    m_castOffMeasureCount = 0;
+    int i;
+    for (i = 0; i < contentSystem->GetChildCount(); i++) {
+        if ( contentSystem->GetChild( i )->IsEditorialElement() ) hasEditorialElement = true;
+        if ( contentSystem->GetChild( i )->Is() == MEASURE ) m_castOffMeasureCount++;
+    }
+    
+    // The measures keep their alignment from the previous layout unless it has been reset. Otherwise,
+    // the layout is kept from now on and it will be complete at the end of the cast off.
+    m_castOffReuseLayout = ( m_castOffLayoutDone && !hasEditorialElement );
+    m_castOffLayoutDone = !hasEditorialElement;
+    
+    // The spacing is the one of the whole content, even when it is laid out in steps
+    m_castOffLongestActualDur = contentPage->GetLongestActualDur();
+    
+    // Keep the content aside - each step adds its own page. The content stays in the uuid index.
+    contentPage->DetachChild( 0, true );
+    this->DetachChild( 0 );
+    delete contentPage;
+    this->ResetDrawingPage( );
+    
+    m_castOffContentSystem = contentSystem;
+    m_castOffContentIdx = 0;
+    m_castOffContentXRel = 0;
+    m_castOffStepMeasureCount = 0;
+    m_castOffPageMeasureCount = 0;
+    
+    this->ContinueCastOff( progressive ? 0 : -1 );
+}
+    
+void Doc::ContinueCastOff( int pageIdx )
+{
+    // The last page is complete only once the next one has been cast off
+    while ( m_castOffContentSystem && ( (pageIdx == -1) || (this->GetChildCount() - 1 <= pageIdx) ) ) {
+        int measureCount = m_castOffMeasureCount;
+        if ( pageIdx != -1 ) {
+            // Enough measures for the pages missing (including the last one again), with the number of measures
+            // per page so far, and at least twice as many as in the previous step
+            int pageCount = pageIdx + 2 - this->GetChildCount();
+            if ( this->GetChildCount() > 1 ) {
+                measureCount = pageCount * m_castOffPageMeasureCount / (this->GetChildCount() - 1);
+            }
+            else {
+                measureCount = pageCount * CASTOFF_STEP_MEASURES;
+            }
+            measureCount = std::max( measureCount, 2 * m_castOffStepMeasureCount );
+        }
+        this->CastOffStep( measureCount );
+    }
+}
+    
+void Doc::CastOffStep( int measureCount )
+{
+    assert( m_castOffContentSystem );
+    
+    // the pages and systems are allocated from the arena of the document
+    ObjectArenaScope arenaScope( &m_objectArena );
+    UuidGeneratorScope uuidScope( &m_uuidGenerator );
+    
+    bool firstStep = ( this->GetChildCount() == 0 );
+    
+    // The page for laying out the next measures is added after the last page for getting the scoreDef at the end of it
+    Page *contentPage = new Page();
+    System *contentSystem = new System();
+    contentPage->AddSystem( contentSystem );
+    this->AddPage( contentPage );
+    this->SetCurrentScoreDef( true );
+    this->SetDrawingPage( contentPage->GetIdx() );
+    
+    // Move the next measures (and the scoreDefs between them) from the content kept aside
+    int count = 0;
+    while ( (m_castOffContentIdx < m_castOffContentSystem->GetChildCount()) && (count < std::max( measureCount, 1 )) ) {
+        Object *child = m_castOffContentSystem->Relinquish( m_castOffContentIdx );
+        child->SetParent( contentSystem );
+        contentSystem->InsertChild( child, contentSystem->GetChildCount() );
+        m_castOffContentIdx++;
+        if ( child->Is() == MEASURE ) count++;
+    }
+    
+    int i;
+    if ( m_castOffReuseLayout ) {
+        // The measures keep their alignment from the previous layout, we only need to put them back
+        // in their position of the single system
+        for (i = 0; i < contentSystem->GetChildCount(); i++) {
+            Measure *measure = dynamic_cast<Measure*>(contentSystem->GetChild( i ));
+            if ( !measure ) continue;
+            measure->ResetJustification();
+            measure->m_drawingXRel = measure->m_castOffXRel;
+        }
+    }
+    else {
+        contentPage->LayOutHorizontally( m_castOffLongestActualDur );
+        // Keep the layout for the next time, with the positions following the ones of the previous steps
+        for (i = 0; i < contentSystem->GetChildCount(); i++) {
+            Measure *measure = dynamic_cast<Measure*>(contentSystem->GetChild( i ));
+            if ( !measure ) continue;
+            measure->m_drawingXRel += m_castOffContentXRel;
+            measure->m_castOffXRel = measure->m_drawingXRel;
+            measure->m_castOffWidth = measure->GetWidth();
+        }
+        m_castOffContentXRel += contentSystem->m_drawingTotalWidth - contentSystem->GetDrawingLabelsWidth();
+        if ( firstStep ) {
+            m_castOffScoreDefWidth = contentPage->m_drawingScoreDef.GetDrawingWidth();
+            m_castOffLabelsWidth = contentSystem->GetDrawingLabelsWidth();
+            m_castOffAbbrLabelsWidth = contentSystem->GetDrawingAbbrLabelsWidth();
+        }
+    }
+    
+    // The scoreDef width at the beginning, then the one at the beginning of the last page (see below)
+    if ( firstStep ) {
+        m_castOffCurrentScoreDefWidth = m_castOffScoreDefWidth + m_castOffAbbrLabelsWidth;
+    }
+    
+    // The content to cast off, starting with the content of the last page given back
+    System *castOffSystem = new System();
+    castOffSystem->SetDrawingAbbrLabelsWidth( m_castOffAbbrLabelsWidth );
+    if ( !firstStep ) {
+        Page *lastPage = dynamic_cast<Page*>(this->GetChild( contentPage->GetIdx() - 1 ) );
+        assert( lastPage );
+        ArrayPtrVoid params;
+        params.push_back( castOffSystem );
+        Functor unCastOff( &Object::UnCastOff );
+        lastPage->Process( &unCastOff, &params );
+        // the measures given back are still referred to by the systems of the page, so keep them in the index
+        this->DetachChild( lastPage->GetIdx(), true );
+        delete lastPage;
+        // Back in their position of the single system, as above
+        for (i = 0; i < castOffSystem->GetChildCount(); i++) {
+            Measure *measure = dynamic_cast<Measure*>(castOffSystem->GetChild( i ));
+            if ( !measure ) continue;
+            measure->ResetJustification();
+            measure->m_drawingXRel = measure->m_castOffXRel;
+        }
+    }
+    castOffSystem->MoveChildren( contentSystem );
+    contentPage->DetachChild( 0, true );
+    delete contentSystem;
+    
     System *currentSystem = new System();
     contentPage->AddSystem( currentSystem );
-    int shift = -contentSystem->GetDrawingLabelsWidth();
+    int shift = -m_castOffLabelsWidth;
+    // Otherwise the first measure starts a system, as in Measure::CastOffSystems
+    Measure *firstMeasure = dynamic_cast<Measure*>(castOffSystem->FindChildByType( MEASURE, 1 ) );
+    if ( !firstStep && firstMeasure ) {
+        shift = firstMeasure->m_drawingXRel;
+    }
     int systemFullWidth = this->m_drawingPageWidth - this->m_drawingPageLeftMar - this->m_drawingPageRightMar
         - currentSystem->m_systemLeftMar - currentSystem->m_systemRightMar;
-    // The width of the initial scoreDef is stored in the page scoreDef
-    int scoreDefWidth = contentPage->m_drawingScoreDef.GetDrawingWidth() + contentSystem->GetDrawingAbbrLabelsWidth();
+    int scoreDefWidth = m_castOffCurrentScoreDefWidth;
     ArrayPtrVoid params;
-    params.push_back( contentSystem );
+    params.push_back( castOffSystem );
     params.push_back( contentPage );
     params.push_back( &currentSystem );
     params.push_back( &shift );
     params.push_back( &systemFullWidth );
     params.push_back( &scoreDefWidth );
+    int contentIdx = 0;
+    params.push_back( &contentIdx );
     Functor castOffSystems( &Object::CastOffSystems );
-    contentSystem->Process( &castOffSystems, &params );
-    delete contentSystem;
+    castOffSystem->Process( &castOffSystems, &params );
+    delete castOffSystem;
     
     // Reset the scoreDef at the beginning of each system
     this->SetCurrentScoreDef( true );
     contentPage->LayOutVertically( );
     
-    // Detach the contentPage
-    this->DetachChild( 0 );
+    // Detach the contentPage - its systems stay in the index since they are moved to the pages
+    this->DetachChild( contentPage->GetIdx(), true );
     assert( contentPage && !contentPage->m_parent );
     
+    int firstPageIdx = this->GetChildCount();
     Page *currentPage = new Page();
     this->AddPage( currentPage );
     shift = 0;
@@ -381,20 +737,126 @@ void Doc::CastOff( )
     params.push_back( &currentPage );
     params.push_back( &shift );
     params.push_back( &pageFullHeight );
+    contentIdx = 0;
+    params.push_back( &contentIdx );
     Functor castOffPages( &Object::CastOffPages );
     contentPage->Process( &castOffPages, &params );
     delete contentPage;
     
     //LogDebug("Layout: %d pages", this->GetChildCount());
+    
+    // Unless the cast off is complete, the last page will be cast off again with the next step. The scoreDef width
+    // at the beginning of it is the one of the last scoreDef before.
+    bool complete = ( m_castOffContentIdx >= m_castOffContentSystem->GetChildCount() );
+    int pageCount = complete ? this->GetChildCount() : this->GetChildCount() - 1;
+    int j, k;
+    for (i = firstPageIdx; i < pageCount; i++) {
+        Object *page = this->GetChild( i );
+        for (j = 0; j < page->GetChildCount(); j++) {
+            Object *system = page->GetChild( j );
+            for (k = 0; k < system->GetChildCount(); k++) {
+                Object *child = system->GetChild( k );
+                if ( child->Is() == SCOREDEF ) {
+                    ScoreDef *scoreDef = dynamic_cast<ScoreDef*>( child );
+                    assert( scoreDef );
+                    m_castOffCurrentScoreDefWidth = scoreDef->GetDrawingWidth() + m_castOffAbbrLabelsWidth;
+                }
+                else if ( child->Is() == MEASURE ) {
+                    m_castOffPageMeasureCount++;
+                }
+            }
+        }
+    }
+    m_castOffStepMeasureCount = count;
+    
+    if ( complete ) {
+        delete m_castOffContentSystem;
+        m_castOffContentSystem = NULL;
+    }
 
     // We need to reset the drawing page to NULL
     // because idx will still be 0 but contentPage is dead!
     this->ResetDrawingPage( );
     this->SetCurrentScoreDef( true );
+    
+    // The scoreDef of the pages laid out before has been reset, so they need to be laid out again
+    for (i = 0; i < firstPageIdx; i++) {
+        Page *page = dynamic_cast<Page*>( this->GetChild( i ) );
+        assert( page );
+        page->ResetLayout();
+    }
+}
+    
+int Doc::GetEstimatedPageCount( )
+{
+    int pageCount = this->GetChildCount();
+    if ( !m_castOffContentSystem || (pageCount < 2) || (m_castOffPageMeasureCount == 0) ) {
+        return pageCount;
+    }
+    // With the number of measures per page of the pages cast off (i.e., without the last one)
+    int estimate = (int)ceil( (double)(pageCount - 1) * m_castOffMeasureCount / m_castOffPageMeasureCount );
+    return std::max( estimate, pageCount );
+}
+    
+int Doc::GetCastOffSystemBreaks( int pageWidth, std::vector<int> *breaks )
+{
+    assert( breaks );
+    breaks->clear();
+    
+    if ( !m_castOffLayoutDone ) {
+        LogWarning( "The horizontal layout for casting off the document is not available" );
+        return VRV_UNSET;
+    }
+    
+    // This follows Measure::CastOffSystems and ScoreDef::CastOffSystems with the positions and the widths
+    // kept by CastOff. The measures are taken from the systems in which they have been cast off, in order.
+    int systemWidth = pageWidth * DEFINITON_FACTOR - this->m_pageLeftMar - this->m_pageRightMar;
+    int shift = -m_castOffLabelsWidth;
+    int scoreDefWidth = m_castOffScoreDefWidth + m_castOffAbbrLabelsWidth;
+    int systemChildCount = 0;
+    int measureIdx = 0;
+    // The smallest system width for which a measure starting a system would fit in the previous one.
+    // The breaks do not change for narrower systems.
+    int nextSystemWidth = VRV_UNSET;
+    
+    int i, j, k;
+    for (i = 0; i < this->GetChildCount(); i++) {
+        Object *page = this->GetChild( i );
+        for (j = 0; j < page->GetChildCount(); j++) {
+            Object *system = page->GetChild( j );
+            for (k = 0; k < system->GetChildCount(); k++) {
+                Object *child = system->GetChild( k );
+                if ( child->Is() == SCOREDEF ) {
+                    ScoreDef *scoreDef = dynamic_cast<ScoreDef*>( child );
+                    assert( scoreDef );
+                    scoreDefWidth = scoreDef->GetDrawingWidth() + m_castOffAbbrLabelsWidth;
+                }
+                else if ( child->Is() == MEASURE ) {
+                    Measure *measure = dynamic_cast<Measure*>( child );
+                    assert( measure );
+                    int width = measure->m_castOffXRel + measure->m_castOffWidth + scoreDefWidth - shift;
+                    if ( (systemChildCount > 0) && (width > systemWidth) ) {
+                        breaks->push_back( measureIdx );
+                        systemChildCount = 0;
+                        shift = measure->m_castOffXRel;
+                        if ( (nextSystemWidth == VRV_UNSET) || (width < nextSystemWidth) ) nextSystemWidth = width;
+                    }
+                    measureIdx++;
+                }
+                systemChildCount++;
+            }
+        }
+    }
+    
+    if ( nextSystemWidth == VRV_UNSET ) return VRV_UNSET;
+    // The smallest page width (in pixels) giving a system at least that wide
+    return ( nextSystemWidth + this->m_pageLeftMar + this->m_pageRightMar + DEFINITON_FACTOR - 1 ) / DEFINITON_FACTOR;
 }
     
 void Doc::UnCastOff( )
-{  
+{
+    UuidGeneratorScope uuidScope( &m_uuidGenerator );
+    
     Page *contentPage = new Page();
     System *contentSystem = new System();
     contentPage->AddSystem( contentSystem );
@@ -405,6 +867,17 @@ void Doc::UnCastOff( )
     Functor unCastOff( &Object::UnCastOff );
     this->Process( &unCastOff, &params );
     
+    // the content kept aside by a progressive cast off follows
+    if ( m_castOffContentSystem ) {
+        for (; m_castOffContentIdx < m_castOffContentSystem->GetChildCount(); m_castOffContentIdx++) {
+            Object *child = m_castOffContentSystem->Relinquish( m_castOffContentIdx );
+            child->SetParent( contentSystem );
+            contentSystem->InsertChild( child, contentSystem->GetChildCount() );
+        }
+        delete m_castOffContentSystem;
+        m_castOffContentSystem = NULL;
+    }
+    
     this->ClearChildren();
     
     this->AddPage(contentPage);
@@ -431,7 +904,7 @@ int Doc::GetGlyphHeight( wchar_t smuflCode, int staffSize, bool graceSize )
 {
     int x, y, w, h;
     Glyph *glyph;
-    glyph = Resources::GetGlyph( smuflCode );
+    glyph = m_resources.GetGlyph( smuflCode );
     assert( glyph );
     glyph->GetBoundingBox( &x, &y, &w, &h );
     h = h * m_drawingSmuflFontSize / glyph->GetUnitsPerEm();
@@ -444,7 +917,7 @@ int Doc::GetGlyphWidth( wchar_t smuflCode, int staffSize, bool graceSize )
 {
     int x, y, w, h;
     Glyph *glyph;
-    glyph = Resources::GetGlyph( smuflCode );
+    glyph = m_resources.GetGlyph( smuflCode );
     assert( glyph );
     glyph->GetBoundingBox( &x, &y, &w, &h );
     w = w * m_drawingSmuflFontSize / glyph->GetUnitsPerEm();
@@ -36,6 +36,7 @@ DrawingListInterface::~DrawingListInterface()
 void DrawingListInterface::Reset()
 {
     m_drawingList.clear();
+    m_drawingListUnsorted = false;
 }
     
     
@@ -43,18 +44,23 @@ void DrawingListInterface::Reset()
 void DrawingListInterface::AddToDrawingList( DocObject *object )
 {
     m_drawingList.push_back( object );
-    m_drawingList.sort();
-    m_drawingList.unique();
+    m_drawingListUnsorted = true;
 }
 
 ListOfObjects *DrawingListInterface::GetDrawingList( )
 {
+    if ( m_drawingListUnsorted ) {
+        m_drawingList.sort();
+        m_drawingList.unique();
+        m_drawingListUnsorted = false;
+    }
     return &m_drawingList;
 }
 
 void DrawingListInterface::ResetDrawingList( )
 {
     m_drawingList.clear();
+    m_drawingListUnsorted = false;
 }
     
 //----------------------------------------------------------------------------
@@ -11,7 +11,10 @@
 //----------------------------------------------------------------------------
 
 #include <assert.h>
+#include <fstream>
+#include <iterator>
 #include <stdlib.h>
+#include <string.h>
 
 //----------------------------------------------------------------------------
 
@@ -19,6 +22,39 @@
 #include "vrv.h"
 
 namespace vrv {
+    
+//----------------------------------------------------------------------------
+// Helpers for the font bundle binary values
+//----------------------------------------------------------------------------
+
+static void WriteBundleInt( std::string *buffer, int value )
+{
+    buffer->append( (const char *)&value, sizeof(int) );
+}
+
+static void WriteBundleString( std::string *buffer, const std::string &value )
+{
+    WriteBundleInt( buffer, (int)value.size() );
+    buffer->append( value );
+}
+
+static bool ReadBundleInt( const char **data, const char *end, int *value )
+{
+    if ( end - (*data) < (int)sizeof(int) ) return false;
+    memcpy( value, (*data), sizeof(int) );
+    (*data) += sizeof(int);
+    return true;
+}
+
+static bool ReadBundleString( const char **data, const char *end, std::string *value )
+{
+    int length;
+    if ( !ReadBundleInt( data, end, &length ) ) return false;
+    if ( (length < 0) || (end - (*data) < length) ) return false;
+    value->assign( (*data), length );
+    (*data) += length;
+    return true;
+}
 
 //----------------------------------------------------------------------------
 // Glyph
@@ -45,11 +81,18 @@ Glyph::Glyph(std::string path, std::string codeStr)
     m_path = path;
     m_codeStr = codeStr;
     
+    // keep the content of the file since it is the definition of the glyph
+    std::ifstream source( path.c_str(), std::ios::binary );
+    if (source.is_open()) {
+        m_xml.assign( std::istreambuf_iterator<char>(source), std::istreambuf_iterator<char>() );
+    }
+    
     pugi::xml_document doc;
-    pugi::xml_parse_result result = doc.load_file( path.c_str() );
+    pugi::xml_parse_result result = doc.load_buffer( m_xml.data(), m_xml.size() );
     if (!result)
     {
         LogError("Font file '%s' could not be loaded", path.c_str() );
+        m_xml.clear();
         return;
     }
     pugi::xml_node root = doc.first_child();
@@ -103,6 +146,36 @@ void Glyph::GetBoundingBox(int *x, int *y, int *w, int *h)
     (*w) = m_width;
     (*h) = m_height;
 }
+    
+bool Glyph::WriteBundle( std::string *buffer )
+{
+    if ( m_xml.empty() ) {
+        LogError("Glyph '%s' has no definition", m_codeStr.c_str() );
+        return false;
+    }
+    
+    WriteBundleInt( buffer, m_unitsPerEm );
+    WriteBundleInt( buffer, m_x );
+    WriteBundleInt( buffer, m_y );
+    WriteBundleInt( buffer, m_width );
+    WriteBundleInt( buffer, m_height );
+    WriteBundleString( buffer, m_codeStr );
+    WriteBundleString( buffer, m_xml );
+    return true;
+}
+    
+bool Glyph::ReadBundle( const char **data, const char *end )
+{
+    if ( !ReadBundleInt( data, end, &m_unitsPerEm ) ) return false;
+    if ( !ReadBundleInt( data, end, &m_x ) ) return false;
+    if ( !ReadBundleInt( data, end, &m_y ) ) return false;
+    if ( !ReadBundleInt( data, end, &m_width ) ) return false;
+    if ( !ReadBundleInt( data, end, &m_height ) ) return false;
+    if ( !ReadBundleString( data, end, &m_codeStr ) ) return false;
+    if ( !ReadBundleString( data, end, &m_xml ) ) return false;
+    m_path = "[bundle]";
+    return true;
+}
 
 
 } // namespace vrv
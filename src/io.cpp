@@ -12,6 +12,10 @@
 
 #include <assert.h>
 
+//----------------------------------------------------------------------------
+
+#include "doc.h"
+
 namespace vrv {
 
 //----------------------------------------------------------------------------
@@ -68,6 +72,9 @@ void FileInputStream::Init( )
     m_hasLayoutInformation = false;
     m_hasMeasureWithinEditMarkup = false;
     m_ignoreLayoutInformation = false;
+    // the imported objects are allocated from the arena of the document and get their uuid from it
+    m_previousArena = ObjectArena::SetCurrent( m_doc->GetObjectArena() );
+    m_previousUuidGenerator = UuidGenerator::SetCurrent( m_doc->GetUuidGenerator() );
 }
     
 FileInputStream::~FileInputStream()
@@ -75,6 +82,8 @@ FileInputStream::~FileInputStream()
     if ( this->is_open()) {
         this->close();
     }
+    ObjectArena::SetCurrent( m_previousArena );
+    UuidGenerator::SetCurrent( m_previousUuidGenerator );
 }
 
 } // namespace vrv
@@ -392,7 +392,7 @@ bool DarmsInput::ImportFile() {
     return ImportString(data);
 }
     
-bool DarmsInput::ImportString(std::string data_str) {
+bool DarmsInput::ImportString(const std::string &data_str) {
     size_t len;
     int res;
     int pos = 0;
@@ -383,9 +383,10 @@ bool MeiOutput::WriteMeiDoc( Doc *doc )
         
         // date
         time_t t = time(0); // get time now
-        struct tm *now = localtime(&t);
-        std::string dateStr = StringFormat("%d-%02d-%02d %02d:%02d:%02d", now->tm_year + 1900, now->tm_mon + 1,
-                                           now->tm_mday, now->tm_hour, now->tm_min, now->tm_sec);
+        struct tm now;
+        localtime_r(&t, &now);
+        std::string dateStr = StringFormat("%d-%02d-%02d %02d:%02d:%02d", now.tm_year + 1900, now.tm_mon + 1,
+                                           now.tm_mday, now.tm_hour, now.tm_min, now.tm_sec);
         date.append_child(pugi::node_pcdata).set_value(dateStr.c_str());
     }
     
@@ -1012,7 +1013,7 @@ bool MeiInput::ImportFile( )
     }
 }
 
-bool MeiInput::ImportString( const std::string mei )
+bool MeiInput::ImportString( const std::string &mei )
 {
     try {
         m_doc->Reset( Raw );
@@ -1027,6 +1028,22 @@ bool MeiInput::ImportString( const std::string mei )
     }
 }
     
+bool MeiInput::ImportBuffer( char *buffer, size_t size )
+{
+    try {
+        m_doc->Reset( Raw );
+        pugi::xml_document doc;
+        // the buffer is parsed in place and the nodes point to it - it must stay valid until ReadMei is done
+        doc.load_buffer_inplace( buffer, size, pugi::parse_default, pugi::encoding_utf8 );
+        pugi::xml_node root = doc.first_child();
+        return ReadMei( root );
+    }
+    catch( char * str ) {
+        LogError("%s", str );
+        return false;
+    }
+}
+    
 bool MeiInput::IsAllowed(std::string element, Object *filterParent)
 {
     if (!filterParent) {
@@ -70,7 +70,7 @@ bool MusicXmlInput::ImportFile()
     }
 }
 
-bool MusicXmlInput::ImportString(const std::string musicxml)
+bool MusicXmlInput::ImportString(const std::string &musicxml)
 {
     try {
         m_doc->Reset( Raw );
@@ -84,6 +84,22 @@ bool MusicXmlInput::ImportString(const std::string musicxml)
         return false;
     }
 }
+
+bool MusicXmlInput::ImportBuffer(char *buffer, size_t size)
+{
+    try {
+        m_doc->Reset( Raw );
+        pugi::xml_document xmlDoc;
+        // the buffer is parsed in place - it must stay valid until ReadMusicXml is done
+        xmlDoc.load_buffer_inplace(buffer, size, pugi::parse_default, pugi::encoding_utf8);
+        pugi::xml_node root = xmlDoc.first_child();
+        return ReadMusicXml(root);
+    }
+    catch(char * str) {
+        LogError("%s", str);
+        return false;
+    }
+}
   
 //////////////////////////////////////////////////////////////////////////////
 // XML helpers
@@ -565,7 +581,7 @@ bool MusicXmlInput::ReadMusicXmlMeasure(pugi::xml_node node, Measure *measure,
     assert(measure);
     
     int measureNb = atoi(GetAttributeValue(node, "number").c_str());
-    if (measure > 0) measure->SetN(measureNb);
+    if (measureNb > 0) measure->SetN(measureNb);
     
     int i = 0;
     for (i = 0; i < nbStaves; i++) {
@@ -54,11 +54,7 @@ char      hum2abc[1024] = {0};       // used with -a option
 int       quietQ  = 0;               // used with -q option
 int       quiet2Q = 0;               // used with -Q option
 
-// Global variables:
-char data_line[10001] = {0};
 #define MAX_DATA_LEN 1024 // One line of the pae file would not be that long!
-char data_key[MAX_DATA_LEN]; 
-char data_value[MAX_DATA_LEN]; //ditto as above
 
 //----------------------------------------------------------------------------
 // PaeInput
@@ -95,7 +91,7 @@ bool PaeInput::ImportFile()
 #endif
 }
 
-bool PaeInput::ImportString(std::string pae)
+bool PaeInput::ImportString(const std::string &pae)
 {
 #ifndef NO_PAE_SUPPORT
     std::istringstream in_stream(pae);
@@ -123,6 +119,10 @@ void PaeInput::parsePlainAndEasy(std::istream &infile) {
     char c_timesig[1024] = {0};
     char c_alttimesig[1024] = {0};
     char incipit[10001] = {0};
+    // local buffers (and not globals) since several documents can be loaded in parallel
+    char data_line[10001] = {0};
+    char data_key[MAX_DATA_LEN];
+    char data_value[MAX_DATA_LEN]; //ditto as above
     int in_beam = 0;
     
     std::string s_key;
@@ -763,9 +763,10 @@ int PaeInput::getTimeInfo( const char* incipit, MeterSig *meter, int index) {
     
     if ( is_standard == 0) {
         char buf_str[1024];
+        char *saveptr;
         strcpy(buf_str, timesig_str);
-        int beats = atoi(strtok(buf_str, "/"));
-        int note_value = atoi(strtok(NULL, "/")); 
+        int beats = atoi(strtok_r(buf_str, "/", &saveptr));
+        int note_value = atoi(strtok_r(NULL, "/", &saveptr));
         meter->SetCount(beats);
         meter->SetUnit(note_value);
     }
@@ -14,6 +14,7 @@
 //----------------------------------------------------------------------------
 
 #include "accid.h"
+#include "att_comparison.h"
 #include "custos.h"
 #include "doc.h"
 #include "keysig.h"
@@ -213,9 +214,9 @@ int Layer::AlignHorizontallyEnd( ArrayPtrVoid *params )
     MeasureAligner **measureAligner = static_cast<MeasureAligner**>((*params).at(0));
     
     int i;
-    for(i = 0; i < (int)(*measureAligner)->m_children.size(); i++) {
-        Alignment *alignment = dynamic_cast<Alignment*>((*measureAligner)->m_children.at(i));
-        if (alignment && alignment->HasGraceAligner()) {
+    for(i = 0; i < (*measureAligner)->GetAlignmentCount(); i++) {
+        Alignment *alignment = (*measureAligner)->GetAlignmentAt(i);
+        if (alignment->HasGraceAligner()) {
             alignment->GetGraceAligner()->AlignStack();
         }
     }
@@ -288,5 +289,55 @@ int Layer::PrepareRpt( ArrayPtrVoid *params )
     }
     return FUNCTOR_CONTINUE;
 }
+    
+int Layer::PrepareByLayer( ArrayPtrVoid *params )
+{
+    // param 0: the MapOfPrepareLayerStates
+    // param 1: the current PrepareLayerState
+    // param 2: the current Staff
+    // param 3: the PrepareLyrics params of the current Verse (unused)
+    // param 4: the MapOfStaffUuidGenerators (unused)
+    MapOfPrepareLayerStates *states = static_cast<MapOfPrepareLayerStates*>((*params).at(0));
+    PrepareLayerState **currentState = static_cast<PrepareLayerState**>((*params).at(1));
+    Staff **currentStaff = static_cast<Staff**>((*params).at(2));
+    
+    assert( (*currentStaff) );
+    
+    // Only the first layer with a given @n is processed within the parent
+    AttCommonNComparison matchLayer( LAYER, this->GetN() );
+    if ( this->HasPreviousSiblingByAttComparison( &matchLayer ) ) {
+        return FUNCTOR_SIBLINGS;
+    }
+    
+    MapOfPrepareLayerStates::iterator iter = states->find( std::make_pair( (*currentStaff)->GetN(), this->GetN() ) );
+    if ( iter == states->end() ) {
+        return FUNCTOR_SIBLINGS;
+    }
+    (*currentState) = &iter->second;
+    
+    // Look at the staffDef when reaching the first staff with the @n
+    if ( (*currentState)->m_multiNumber == BOOLEAN_NONE ) {
+        (*currentStaff)->PrepareRpt( &(*currentState)->m_rptParams );
+    }
+    if ( (*currentState)->m_multiNumber != BOOLEAN_false ) {
+        this->PrepareRpt( &(*currentState)->m_rptParams );
+    }
+    
+    return FUNCTOR_CONTINUE;
+}
+    
+int Layer::PrepareByLayerEnd( ArrayPtrVoid *params )
+{
+    // param 0: the MapOfPrepareLayerStates (unused)
+    // param 1: the current PrepareLayerState
+    // param 2: the current Staff (unused)
+    // param 3: the PrepareLyrics params of the current Verse (unused)
+    // param 4: the MapOfStaffUuidGenerators (unused)
+    PrepareLayerState **currentState = static_cast<PrepareLayerState**>((*params).at(1));
+    
+    (*currentState) = NULL;
+    
+    return FUNCTOR_CONTINUE;
+}
 
 } // namespace vrv
@@ -353,19 +353,41 @@ int LayerElement::AlignHorizontally( ArrayPtrVoid *params )
 
 int LayerElement::PrepareTimeSpanning( ArrayPtrVoid *params )
 {
-    // param 0: std::vector<DocObject*>* that holds the current elements to match
+    // param 0: std::vector<DocObject*>* that holds all the elements to match (unused)
     // param 1: bool* fillList for indicating whether the elements have to be stack or not (unused)
-    std::vector<DocObject*> *elements = static_cast<std::vector<DocObject*>*>((*params).at(0));
-    
-    std::vector<DocObject*>::iterator iter = elements->begin();
-    while ( iter != elements->end()) {
-        TimeSpanningInterface *interface = dynamic_cast<TimeSpanningInterface*>(*iter);
-        assert(interface);
-        if (interface->SetStartAndEnd( this ) ) {
-            iter = elements->erase( iter );
+    // param 2: MapOfUuidTimeSpanningInterfaces* of the elements with a start still to match
+    // param 3: MapOfUuidTimeSpanningInterfaces* of the elements with an end still to match
+    MapOfUuidTimeSpanningInterfaces *starts = static_cast<MapOfUuidTimeSpanningInterfaces*>((*params).at(2));
+    MapOfUuidTimeSpanningInterfaces *ends = static_cast<MapOfUuidTimeSpanningInterfaces*>((*params).at(3));
+    
+    std::vector<TimeSpanningInterface*>::iterator interfaceIter;
+    std::vector<TimeSpanningInterface*> started;
+    MapOfUuidTimeSpanningInterfaces::iterator iter = starts->find( this->GetUuid() );
+    if ( iter != starts->end() ) {
+        started.swap( iter->second );
+        starts->erase( iter );
+        for (interfaceIter = started.begin(); interfaceIter != started.end(); ++interfaceIter) {
+            (*interfaceIter)->SetStart( this );
+        }
+    }
+    
+    iter = ends->find( this->GetUuid() );
+    if ( iter != ends->end() ) {
+        std::vector<TimeSpanningInterface*> remaining;
+        for (interfaceIter = iter->second.begin(); interfaceIter != iter->second.end(); ++interfaceIter) {
+            // An element that was just set as start will be set as end only when processed again
+            if ( std::find( started.begin(), started.end(), *interfaceIter ) != started.end() ) {
+                remaining.push_back( *interfaceIter );
+            }
+            else {
+                (*interfaceIter)->SetEnd( this );
+            }
+        }
+        if ( remaining.empty() ) {
+            ends->erase( iter );
         }
         else {
-            iter++;
+            iter->second.swap( remaining );
         }
     }
     
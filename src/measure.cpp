@@ -57,6 +57,8 @@ void Measure::Reset()
     m_xAbs = VRV_UNSET;
     m_drawingXRel = 0;
     m_drawingX = 0;
+    m_castOffXRel = 0;
+    m_castOffWidth = 0;
     
     // by default, we have a single barLine on the right (none on the left)
     m_rightBarline.SetRend( this->GetRight() );
@@ -131,6 +133,14 @@ int Measure::GetWidth()
     }
     return 0;
 }
+    
+int Measure::GetNonJustifiedWidth()
+{
+    if ( m_measureAligner.GetRightAlignment() ) {
+        return m_measureAligner.GetNonJustifiedRightXRel() + m_measureAligner.GetRightAlignment()->GetMaxWidth();
+    }
+    return 0;
+}
  
 //----------------------------------------------------------------------------
 // Measure functor methods
@@ -272,14 +282,16 @@ int Measure::CastOffSystems( ArrayPtrVoid *params )
     // param 3: the cummulated shift (m_drawingXRel of the first measure of the current system)
     // param 4: the system width
     // param 5: the current scoreDef width
+    // param 6: the index of the previous child moved from the content system
     System *contentSystem = static_cast<System*>((*params).at(0));
     Page *page = static_cast<Page*>((*params).at(1));
     System **currentSystem = static_cast<System**>((*params).at(2));
     int *shift = static_cast<int*>((*params).at(3));
     int *systemWidth = static_cast<int*>((*params).at(4));
     int *currentScoreDefWidth = static_cast<int*>((*params).at(5));
+    int *contentIdx = static_cast<int*>((*params).at(6));
     
-    if ( ( (*currentSystem)->GetChildCount() > 0 ) && ( this->m_drawingXRel + this->GetWidth() + (*currentScoreDefWidth) - (*shift) > (*systemWidth) ) ) {
+    if ( ( (*currentSystem)->GetChildCount() > 0 ) && ( this->m_drawingXRel + this->m_castOffWidth + (*currentScoreDefWidth) - (*shift) > (*systemWidth) ) ) {
         (*currentSystem) = new System();
         page->AddSystem( *currentSystem );
         (*shift) = this->m_drawingXRel;;
@@ -289,10 +301,18 @@ int Measure::CastOffSystems( ArrayPtrVoid *params )
     // We want to move the measure to the currentSystem. However, we cannot use DetachChild
     // from the content System because this screws up the iterator. Relinquish gives up
     // the ownership of the Measure - the contentSystem will be deleted afterwards.
-    Measure *measure = dynamic_cast<Measure*>( contentSystem->Relinquish( this->GetIdx()) );
+    // The children are processed in order, so we look for the index from the previous one.
+    (*contentIdx) = contentSystem->GetChildIndex( this, (*contentIdx) );
+    Measure *measure = dynamic_cast<Measure*>( contentSystem->Relinquish( (*contentIdx) ) );
     assert( measure );
     (*currentSystem)->AddMeasure( measure );
     
+    // Keep the width available for the measures in the system (i.e., without the scoreDef and from
+    // the position of its first measure) for checking later if the measure breaks change
+    Measure *firstMeasure = dynamic_cast<Measure*>((*currentSystem)->FindChildByType( MEASURE, 1 ) );
+    assert( firstMeasure );
+    (*currentSystem)->m_drawingCastOffWidth = (*systemWidth) - (*currentScoreDefWidth) + (*shift) - firstMeasure->m_drawingXRel;
+    
     return FUNCTOR_SIBLINGS;
 }
    
@@ -176,8 +176,10 @@ int Note::PrepareTieAttr( ArrayPtrVoid *params )
 {
     // param 0: std::vector<Note*>* that holds the current notes with open ties
     // param 1: Chord** currentChord for the current chord if in a chord
+    // param 2: std::vector<std::string>* for the warnings
     std::vector<Note*> *currentNotes = static_cast<std::vector<Note*>*>((*params).at(0));
     Chord **currentChord = static_cast<Chord**>((*params).at(1));
+    std::vector<std::string> *warnings = static_cast<std::vector<std::string>*>((*params).at(2));
     
     AttTiepresent *check = this;
     // Use the parent chord if there is no @tie on the note
@@ -196,7 +198,7 @@ int Note::PrepareTieAttr( ArrayPtrVoid *params )
                 (*iter)->GetDrawingTieAttr()->SetEnd(this);
             }
             else {
-                LogWarning("Expected @tie median or terminal in note '%s', skipping it", this->GetUuid().c_str());
+                warnings->push_back( StringFormat("Expected @tie median or terminal in note '%s', skipping it", this->GetUuid().c_str()) );
                 (*iter)->ResetDrawingTieAttr();
             }
             iter = currentNotes->erase( iter );
@@ -263,6 +265,9 @@ int Note::PreparePointersByLayer( ArrayPtrVoid *params )
 int Note::ResetDrawing( ArrayPtrVoid *params )
 {
     this->ResetDrawingTieAttr();
+    // Also deleted here (and not only in PreparePointersByLayer) because the objects allocated from
+    // the arena of the document cannot be deleted by the PrepareDrawing threads
+    this->ResetDrawingAccid();
     return FUNCTOR_CONTINUE;
 };
 
@@ -8,7 +8,9 @@
 
 //----------------------------------------------------------------------------
 
+#include <algorithm>
 #include <assert.h>
+#include <pthread.h>
 #include <sstream>
 #include <iostream>
 
@@ -35,6 +37,50 @@ namespace vrv {
 // Object
 //----------------------------------------------------------------------------
 
+/**
+ * The UuidGenerator used when the thread has no current one (see Object::SeedUuidGenerator).
+ * It is shared by all the threads and locked with s_uuidGeneratorMutex.
+ */
+static UuidGenerator s_uuidGenerator;
+static pthread_mutex_t s_uuidGeneratorMutex = PTHREAD_MUTEX_INITIALIZER;
+
+// The size of the header before each object, where the arena is stored, which keeps the alignment
+#define OBJECT_HEADER_SIZE 16
+
+// The value of Object::m_uuidNr once the uuid is written (the uuid numbers are below 10^15)
+#define UUID_WRITTEN 0xFFFFFFFFFFFFFFFFULL
+
+void *Object::operator new( size_t size )
+{
+    ObjectArena *arena = ObjectArena::GetCurrent();
+    void *block = NULL;
+    if ( arena ) {
+        block = arena->Allocate( size + OBJECT_HEADER_SIZE );
+    }
+    // no arena or too large for it
+    if ( !block ) {
+        arena = NULL;
+        block = ::operator new( size + OBJECT_HEADER_SIZE );
+    }
+    *static_cast<ObjectArena**>( block ) = arena;
+    return static_cast<char*>( block ) + OBJECT_HEADER_SIZE;
+}
+
+void Object::operator delete( void *ptr, size_t size )
+{
+    if ( !ptr ) {
+        return;
+    }
+    char *block = static_cast<char*>( ptr ) - OBJECT_HEADER_SIZE;
+    ObjectArena *arena = *reinterpret_cast<ObjectArena**>( block );
+    if ( arena ) {
+        arena->Free( block, size + OBJECT_HEADER_SIZE );
+    }
+    else {
+        ::operator delete( block );
+    }
+}
+
 Object::Object()
 {
     Init("m-");
@@ -56,8 +102,11 @@ Object::Object( const Object& object )
 {
     ClearChildren();
     m_parent = NULL;
+    // the copy is not in the index
+    m_uuidIndexDoc = NULL;
     m_classid = object.m_classid;
     m_uuid = object.m_uuid; // for now copy the uuid - to be decided
+    m_uuidNr = object.m_uuidNr;
     m_isModified = true;
     
     int i;
@@ -76,9 +125,14 @@ Object& Object::operator=( const Object& object )
 	if ( this != &object ) // not self assignement
 	{
         ClearChildren();
+        if ( m_uuidIndexDoc ) {
+            m_uuidIndexDoc->RemoveFromUuidIndex( this->GetUuid(), this );
+            m_uuidIndexDoc = NULL;
+        }
         m_parent = NULL;
         m_classid = object.m_classid;
         m_uuid = object.m_uuid; // for now copy the uuid - to be decided
+        m_uuidNr = object.m_uuidNr;
         m_isModified = true;
         
         int i;
@@ -96,12 +150,18 @@ Object& Object::operator=( const Object& object )
     
 Object::~Object()
 {
+    // A Doc in its own index is already destroyed at this stage
+    if ( m_uuidIndexDoc && ( m_uuidIndexDoc != this ) ) {
+        m_uuidIndexDoc->RemoveFromUuidIndex( this->GetUuid(), this );
+    }
+    // the children remove themselves from the index
     ClearChildren();
 }
 
 void Object::Init(std::string classid)
 {
     m_parent = NULL;
+    m_uuidIndexDoc = NULL;
     m_isModified = true;
     m_classid = classid;
     this->GenerateUuid();
@@ -132,14 +192,23 @@ void Object::MoveChildren(  Object *object )
     int i;
     for (i = 0; i < (int)object->m_children.size(); i++)
     {
-        this->m_children.push_back( object->Relinquish(i) );
-        object->m_children.at(i)->m_parent = this;
+        Object *child = object->Relinquish(i);
+        child->SetParent( this );
+        this->m_children.push_back( child );
     }
 }
 
 void Object::SetUuid( std::string uuid )
 { 
+    Doc *doc = m_uuidIndexDoc;
+    if ( doc ) {
+        doc->RemoveFromUuidIndex( this, 0 );
+    }
     m_uuid = uuid;
+    m_uuidNr = UUID_WRITTEN;
+    if ( doc ) {
+        doc->AddToUuidIndex( this, 0 );
+    }
 };
 
 void Object::ClearChildren()
@@ -217,18 +286,23 @@ void Object::InsertChild( Object *element, int idx )
     
     if ( idx >= (int)m_children.size() ) {
         m_children.push_back( element );
-        return;
     }
-    ArrayOfObjects::iterator iter = m_children.begin();
-    m_children.insert( iter+(idx), element );
+    else {
+        ArrayOfObjects::iterator iter = m_children.begin();
+        m_children.insert( iter+(idx), element );
+    }
+    // the element was added to the uuid index by SetParent
 }
 
-Object *Object::DetachChild( int idx )
+Object *Object::DetachChild( int idx, bool keepInUuidIndex )
 {
     if ( idx >= (int)m_children.size() ) {
         return NULL;
     }
     Object *child = m_children.at(idx);
+    if ( child->m_uuidIndexDoc && !keepInUuidIndex ) {
+        child->m_uuidIndexDoc->RemoveFromUuidIndex( child );
+    }
     child->m_parent = NULL;
     ArrayOfObjects::iterator iter = m_children.begin();
     m_children.erase( iter+(idx) );
@@ -298,30 +372,67 @@ void Object::RemoveChildAt( int idx )
     if ( idx >= (int)m_children.size() ) {
         return;
     }
+    // the child removes itself from the uuid index
     delete m_children.at(idx);
     ArrayOfObjects::iterator iter = m_children.begin();
     m_children.erase( iter+(idx) );
 }
 
+std::string Object::GetUuid() const
+{
+    if ( m_uuidNr != UUID_WRITTEN ) {
+        UuidGenerator::Write( m_classid, m_uuidNr, &m_uuid );
+        m_uuidNr = UUID_WRITTEN;
+    }
+    return m_uuid;
+}
+
 void Object::GenerateUuid()
 {
-    int nr = std::rand();
-    char str[17];
-    // I do not want to use a stream to do this!
-    snprintf (str, 16, "%016d", nr);
-    
-    m_uuid = m_classid + std::string(str);
+    // the previous uuid, if any, is not valid anymore
+    m_uuid.clear();
+    UuidGenerator *generator = UuidGenerator::GetCurrent();
+    if ( generator ) {
+        m_uuidNr = generator->Next();
+        return;
+    }
+    pthread_mutex_lock( &s_uuidGeneratorMutex );
+    m_uuidNr = s_uuidGenerator.Next();
+    pthread_mutex_unlock( &s_uuidGeneratorMutex );
 }
 
 void Object::ResetUuid()
 {
-    GenerateUuid();
+    Doc *doc = m_uuidIndexDoc;
+    if ( doc ) {
+        doc->RemoveFromUuidIndex( this, 0 );
+    }
+    this->GenerateUuid();
+    if ( doc ) {
+        doc->AddToUuidIndex( this, 0 );
+    }
+}
+    
+void Object::SeedUuidGenerator( unsigned int seed )
+{
+    pthread_mutex_lock( &s_uuidGeneratorMutex );
+    s_uuidGenerator.Seed( seed );
+    pthread_mutex_unlock( &s_uuidGeneratorMutex );
 }
 
 void Object::SetParent( Object *parent )
 {
     assert( !m_parent );
     m_parent = parent;
+    if ( !parent->m_uuidIndexDoc ) {
+        // keep the entries of the Object since it is still part of its document
+        return;
+    }
+    if ( m_uuidIndexDoc && ( m_uuidIndexDoc != parent->m_uuidIndexDoc ) ) {
+        m_uuidIndexDoc->RemoveFromUuidIndex( this );
+    }
+    // nothing is done if the Object is already in the index (see Object::UpdateUuidIndex)
+    parent->m_uuidIndexDoc->AddToUuidIndex( this );
 }
     
 void Object::AddEditorialElement( EditorialElement *child )
@@ -341,11 +452,14 @@ void Object::AddEditorialElement( EditorialElement *child )
     Modify();
 }
 
-int Object::GetChildIndex( const Object *child )
+int Object::GetChildIndex( const Object *child, int startIdx )
 {
+    if ( startIdx >= (int)m_children.size() ) {
+        return -1;
+    }
     ArrayOfObjects::iterator iter;
     int i;
-    for (iter = m_children.begin(), i = 0; iter != m_children.end(); ++iter, i++)
+    for (iter = m_children.begin() + startIdx, i = startIdx; iter != m_children.end(); ++iter, i++)
     {
         if ( child == *iter ) {
             return i;
@@ -355,6 +469,21 @@ int Object::GetChildIndex( const Object *child )
     return -1;
 }
 
+bool Object::HasPreviousSiblingByAttComparison( AttComparison *attComparison )
+{
+    if ( !m_parent ) {
+        return false;
+    }
+    ArrayOfObjects::iterator iter;
+    for (iter = m_parent->m_children.begin(); (iter != m_parent->m_children.end()) && (*iter != this); ++iter)
+    {
+        if ( (*attComparison)(*iter) ) {
+            return true;
+        }
+    }
+    return false;
+}
+
 void Object::Modify( bool modified )
 {    
     // if we have a parent and a new modification, propagate it
@@ -676,6 +805,7 @@ ObjectListInterface& ObjectListInterface::operator=( const ObjectListInterface&
     // actually nothing to do, we just don't want the list to be copied
     if ( this != &interface ) {
         this->m_list.clear();
+        this->IndexList();
     }
 	return *this;
 }
@@ -691,6 +821,45 @@ void ObjectListInterface::ResetList( Object *node )
     m_list.clear();
     node->FillFlatList( &m_list );
     this->FilterList( &m_list );
+    this->IndexList();
+}
+    
+void ObjectListInterface::IndexList( )
+{
+    m_listArray.assign( m_list.begin(), m_list.end() );
+    m_listPreviousIndexes.clear();
+    
+    int size = 0;
+    if ( !m_listArray.empty() ) {
+        size = 8;
+        while ( size < 2 * (int)m_listArray.size() ) {
+            size *= 2;
+        }
+    }
+    m_listIndexes.assign( size, std::make_pair( (const Object*)NULL, -1 ) );
+    
+    int i;
+    for (i = 0; i < (int)m_listArray.size(); i++) {
+        int slot = GetListIndexSlot( m_listArray.at(i) );
+        // the first position is kept for an object appearing twice, as with a linear search
+        if ( !m_listIndexes.at(slot).first ) {
+            m_listIndexes.at(slot) = std::make_pair( m_listArray.at(i), i );
+        }
+    }
+}
+
+int ObjectListInterface::GetListIndexSlot( const Object *listElement )
+{
+    assert( !m_listIndexes.empty() );
+    
+    // the size is a power of two
+    size_t mask = m_listIndexes.size() - 1;
+    // the low bits of the address are the same for all the objects because of the alignment
+    size_t slot = ( ( (size_t)listElement >> 4 ) * 2654435761U ) & mask;
+    while ( m_listIndexes.at(slot).first && ( m_listIndexes.at(slot).first != listElement ) ) {
+        slot = ( slot + 1 ) & mask;
+    }
+    return (int)slot;
 }
 
 ListOfObjects *ObjectListInterface::GetList( Object *node )
@@ -702,72 +871,254 @@ ListOfObjects *ObjectListInterface::GetList( Object *node )
 
 int ObjectListInterface::GetListIndex( const Object *listElement )
 {
-    ListOfObjects::iterator iter;
-    int i;
-    for (iter = m_list.begin(), i = 0; iter != m_list.end(); ++iter, i++)
-    {
-        if ( listElement == *iter ) {
-            return i;
-        }
-        
+    if ( m_listIndexes.empty() ) {
+        return -1;
     }
-    return -1;
+    // the position is -1 for an empty slot
+    return m_listIndexes.at( GetListIndexSlot( listElement ) ).second;
 }
 
     
 Object* ObjectListInterface::GetListFirst(const Object *startFrom, const ClassId classId)
 {
-    ListOfObjects::iterator it = m_list.begin();
-    std::advance(it, GetListIndex(startFrom));
-    it = std::find_if(it, m_list.end(), ObjectComparison( classId ) );
-    return (it == m_list.end()) ? NULL : *it;
+    int idx = GetListIndex(startFrom);
+    if ( idx == -1 ) {
+        return NULL;
+    }
+    ArrayOfObjects::iterator it = std::find_if(m_listArray.begin() + idx, m_listArray.end(), ObjectComparison( classId ) );
+    return (it == m_listArray.end()) ? NULL : *it;
 }
     
 Object* ObjectListInterface::GetListFirstBackward(Object *startFrom, const ClassId classId)
 {
-    ListOfObjects::iterator it = m_list.begin();
-    std::advance(it, GetListIndex(startFrom));
-    ListOfObjects::reverse_iterator rit(it);
-    rit = std::find_if(rit, m_list.rend(), ObjectComparison( classId ) );
-    return (rit == m_list.rend()) ? NULL : *rit;
+    // search from the end of the list if not found
+    int idx = GetListIndex(startFrom);
+    if ( idx == -1 ) {
+        idx = (int)m_listArray.size();
+    }
+    if ( idx == 0 ) {
+        return NULL;
+    }
+    if ( classId == UNSPECIFIED ) {
+        return m_listArray.at( idx - 1 );
+    }
+    
+    // Fill the previous positions for the class the first time we look for it
+    std::map<ClassId, std::vector<int> >::iterator iter = m_listPreviousIndexes.find( classId );
+    if ( iter == m_listPreviousIndexes.end() ) {
+        std::vector<int> previous( m_listArray.size() + 1, -1 );
+        int i;
+        for (i = 0; i < (int)m_listArray.size(); i++) {
+            previous.at(i + 1) = ( m_listArray.at(i)->Is() == classId ) ? i : previous.at(i);
+        }
+        iter = m_listPreviousIndexes.insert( std::make_pair( classId, previous ) ).first;
+    }
+    
+    int previousIdx = iter->second.at( idx );
+    return ( previousIdx == -1 ) ? NULL : m_listArray.at( previousIdx );
 }
     
 Object *ObjectListInterface::GetListPrevious( const Object *listElement )
 {
-    ListOfObjects::iterator iter;
-    int i;
-    for (iter = m_list.begin(), i = 0; iter != m_list.end(); ++iter, i++)
-    {
-        if (listElement == *iter) {
-            if (i > 0) {
-                return *(--iter);
-            }
-            else {
-                return NULL;
-            }
-        }
-        
+    int idx = GetListIndex( listElement );
+    if ( idx < 1 ) {
+        return NULL;
     }
-    return NULL;
+    return m_listArray.at( idx - 1 );
 }
 
 Object *ObjectListInterface::GetListNext( const Object *listElement )
 {
-    ListOfObjects::reverse_iterator iter;
+    int idx = GetListIndex( listElement );
+    if ( ( idx == -1 ) || ( idx + 1 >= (int)m_listArray.size() ) ) {
+        return NULL;
+    }
+    return m_listArray.at( idx + 1 );
+}
+
+//----------------------------------------------------------------------------
+// UuidGenerator
+//----------------------------------------------------------------------------
+
+// The number of digits of the uuids and 10^UUID_DIGITS
+#define UUID_DIGITS 15
+#define UUID_MODULO 1000000000000000ULL
+
+/**
+ * Mix the bits of a value (finalizer of SplitMix64).
+ */
+static unsigned long long MixUuidBits( unsigned long long value )
+{
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+    return value ^ (value >> 31);
+}
+
+UuidGenerator::UuidGenerator()
+{
+    Seed( 0 );
+}
+
+void UuidGenerator::Seed( unsigned int seed )
+{
+    m_seed = seed;
+    m_counter = 0;
+    // The multiplier has to be coprime with 10^UUID_DIGITS for the permutation to be a bijection,
+    // and below 2^31 for the product with the (32-bit) counter not to overflow
+    m_multiplier = ( MixUuidBits( seed ) & 0x7FFFFFFFULL ) | 1;
+    if ( m_multiplier % 5 == 0 ) {
+        m_multiplier += 2;
+    }
+    m_offset = MixUuidBits( (unsigned long long)seed + 0x9E3779B97F4A7C15ULL ) % UUID_MODULO;
+}
+
+void UuidGenerator::Derive( const UuidGenerator *generator, unsigned int first )
+{
+    m_seed = generator->m_seed;
+    m_counter = first;
+    m_multiplier = generator->m_multiplier;
+    m_offset = generator->m_offset;
+}
+
+unsigned long long UuidGenerator::Next( )
+{
+#ifdef __GNUC__
+    unsigned int counter = __sync_fetch_and_add( &m_counter, 1 );
+#else
+    unsigned int counter = m_counter++;
+#endif
+    return ( m_multiplier * counter + m_offset ) % UUID_MODULO;
+}
+
+void UuidGenerator::Write( const std::string &prefix, unsigned long long nr, std::string *uuid )
+{
+    char digits[UUID_DIGITS];
     int i;
-    for (iter = m_list.rbegin(), i = 0; iter != m_list.rend(); ++iter, i++)
-    {
-        if ( listElement == *iter ) {
-            if (i > 0) {
-                return *(--iter);
-            }
-            else {
-                return NULL;
-            }
+    for (i = UUID_DIGITS - 1; i >= 0; i--) {
+        digits[i] = '0' + (char)( nr % 10 );
+        nr /= 10;
+    }
+    uuid->reserve( prefix.size() + UUID_DIGITS );
+    uuid->assign( prefix );
+    uuid->append( digits, UUID_DIGITS );
+}
+
+static pthread_key_t s_currentUuidGeneratorKey;
+static pthread_once_t s_currentUuidGeneratorKeyOnce = PTHREAD_ONCE_INIT;
+
+static void CreateCurrentUuidGeneratorKey( )
+{
+    pthread_key_create( &s_currentUuidGeneratorKey, NULL );
+}
+
+UuidGenerator *UuidGenerator::GetCurrent( )
+{
+    pthread_once( &s_currentUuidGeneratorKeyOnce, CreateCurrentUuidGeneratorKey );
+    return static_cast<UuidGenerator*>( pthread_getspecific( s_currentUuidGeneratorKey ) );
+}
+
+UuidGenerator *UuidGenerator::SetCurrent( UuidGenerator *generator )
+{
+    UuidGenerator *previous = GetCurrent();
+    pthread_setspecific( s_currentUuidGeneratorKey, generator );
+    return previous;
+}
+
+//----------------------------------------------------------------------------
+// ObjectArena
+//----------------------------------------------------------------------------
+
+// The size of the chunks, the granularity of the block sizes and the largest block size
+#define ARENA_CHUNK_SIZE 262144
+#define ARENA_BLOCK_ALIGNMENT 16
+#define ARENA_MAX_BLOCK_SIZE 4096
+
+static pthread_key_t s_currentArenaKey;
+static pthread_once_t s_currentArenaKeyOnce = PTHREAD_ONCE_INIT;
+
+static void CreateCurrentArenaKey( )
+{
+    pthread_key_create( &s_currentArenaKey, NULL );
+}
+
+ObjectArena::ObjectArena()
+{
+    m_next = NULL;
+    m_left = 0;
+    m_freeBlocks.resize( ARENA_MAX_BLOCK_SIZE / ARENA_BLOCK_ALIGNMENT + 1, NULL );
+    m_allocatedBlocks = 0;
+}
+
+ObjectArena::~ObjectArena()
+{
+    // Objects still allocated would point to a deleted arena - this should not happen
+    // but we would rather keep the chunks (that is leak them) in such a case
+    assert( m_allocatedBlocks == 0 );
+    if ( m_allocatedBlocks == 0 ) {
+        Release();
+    }
+}
+
+void *ObjectArena::Allocate( size_t size )
+{
+    if ( size > ARENA_MAX_BLOCK_SIZE ) {
+        return NULL;
+    }
+    size_t sizeClass = ( size + ARENA_BLOCK_ALIGNMENT - 1 ) / ARENA_BLOCK_ALIGNMENT;
+    void *block = m_freeBlocks.at( sizeClass );
+    if ( block ) {
+        // take the first freed block, the next one being stored in it
+        m_freeBlocks.at( sizeClass ) = *static_cast<void**>( block );
+    }
+    else {
+        size = sizeClass * ARENA_BLOCK_ALIGNMENT;
+        if ( m_left < size ) {
+            m_chunks.push_back( static_cast<char*>( ::operator new( ARENA_CHUNK_SIZE ) ) );
+            m_next = m_chunks.back();
+            m_left = ARENA_CHUNK_SIZE;
         }
-        
+        block = m_next;
+        m_next += size;
+        m_left -= size;
     }
-    return NULL;
+    m_allocatedBlocks++;
+    return block;
+}
+
+void ObjectArena::Free( void *block, size_t size )
+{
+    size_t sizeClass = ( size + ARENA_BLOCK_ALIGNMENT - 1 ) / ARENA_BLOCK_ALIGNMENT;
+    *static_cast<void**>( block ) = m_freeBlocks.at( sizeClass );
+    m_freeBlocks.at( sizeClass ) = block;
+    m_allocatedBlocks--;
+}
+
+void ObjectArena::Release( )
+{
+    if ( m_allocatedBlocks != 0 ) {
+        return;
+    }
+    std::vector<char*>::iterator iter;
+    for (iter = m_chunks.begin(); iter != m_chunks.end(); ++iter) {
+        ::operator delete( *iter );
+    }
+    m_chunks.clear();
+    m_next = NULL;
+    m_left = 0;
+    std::fill( m_freeBlocks.begin(), m_freeBlocks.end(), (void*)NULL );
+}
+
+ObjectArena *ObjectArena::GetCurrent( )
+{
+    pthread_once( &s_currentArenaKeyOnce, CreateCurrentArenaKey );
+    return static_cast<ObjectArena*>( pthread_getspecific( s_currentArenaKey ) );
+}
+
+ObjectArena *ObjectArena::SetCurrent( ObjectArena *arena )
+{
+    ObjectArena *previous = GetCurrent();
+    pthread_setspecific( s_currentArenaKey, arena );
+    return previous;
 }
 
 //----------------------------------------------------------------------------
@@ -808,6 +1159,51 @@ int Object::AddLayerElementToFlatList( ArrayPtrVoid *params )
     return FUNCTOR_CONTINUE;
 }
 
+int Object::PrepareByLayer( ArrayPtrVoid *params )
+{
+    // param 0: the MapOfPrepareLayerStates (unused)
+    // param 1: the current PrepareLayerState
+    // param 2: the current Staff (unused)
+    // param 3: the PrepareLyrics params of the current Verse (unused)
+    // param 4: the MapOfStaffUuidGenerators (unused)
+    PrepareLayerState **currentState = static_cast<PrepareLayerState**>((*params).at(1));
+    
+    // Not within a layer
+    if ( !(*currentState) ) {
+        return FUNCTOR_CONTINUE;
+    }
+    
+    this->PrepareTieAttr( &(*currentState)->m_tieAttrParams );
+    this->PreparePointersByLayer( &(*currentState)->m_pointersParams );
+    // The lyrics are processed only for the layers with verses - the last notes are shared by the verses
+    // and the current syl is not used by Note::PrepareLyrics, so we can use the params of any verse
+    if ( !(*currentState)->m_lyricsParams.empty() ) {
+        this->PrepareLyrics( &(*currentState)->m_lyricsParams.begin()->second );
+    }
+    // @multi.number is false for the staff
+    if ( (*currentState)->m_multiNumber != BOOLEAN_false ) {
+        this->PrepareRpt( &(*currentState)->m_rptParams );
+    }
+    
+    return FUNCTOR_CONTINUE;
+}
+
+int Object::PrepareByLayerEnd( ArrayPtrVoid *params )
+{
+    // param 0: the MapOfPrepareLayerStates (unused)
+    // param 1: the current PrepareLayerState
+    // param 2: the current Staff (unused)
+    // param 3: the PrepareLyrics params of the current Verse (unused)
+    // param 4: the MapOfStaffUuidGenerators (unused)
+    PrepareLayerState **currentState = static_cast<PrepareLayerState**>((*params).at(1));
+    
+    if ( (*currentState) ) {
+        this->PrepareTieAttrEnd( &(*currentState)->m_tieAttrParams );
+    }
+    
+    return FUNCTOR_CONTINUE;
+}
+
 int Object::FindByUuid( ArrayPtrVoid *params )
 {
     // param 0: the uuid we are looking for
@@ -829,6 +1225,36 @@ int Object::FindByUuid( ArrayPtrVoid *params )
     return FUNCTOR_CONTINUE;
 }
 
+int Object::UpdateUuidIndex( ArrayPtrVoid *params )
+{
+    // param 0: the MapOfUuidObjects
+    // param 1: the flag for adding or removing
+    // param 2: the Doc of the index
+    MapOfUuidObjects *uuidIndex = static_cast<MapOfUuidObjects*>((*params).at(0));
+    bool *add = static_cast<bool*>((*params).at(1));
+    Doc *doc = static_cast<Doc*>((*params).at(2));
+    
+    if ( (*add) ) {
+        MapOfUuidObjects::iterator iter = uuidIndex->find( this->GetUuid() );
+        // already in the index, and so are the children since they are added and removed with it
+        if ( ( m_uuidIndexDoc == doc ) && ( iter != uuidIndex->end() ) && ( iter->second == this ) ) {
+            return FUNCTOR_SIBLINGS;
+        }
+        // the first object with the uuid stays in the index
+        uuidIndex->insert( std::make_pair( this->GetUuid(), this ) );
+        m_uuidIndexDoc = doc;
+        return FUNCTOR_CONTINUE;
+    }
+    
+    // remove it only if the uuid is the one of this object
+    MapOfUuidObjects::iterator iter = uuidIndex->find( this->GetUuid() );
+    if ( ( iter != uuidIndex->end() ) && ( iter->second == this ) ) {
+        uuidIndex->erase( iter );
+    }
+    m_uuidIndexDoc = NULL;
+    return FUNCTOR_CONTINUE;
+}
+    
 int Object::FindByAttComparison( ArrayPtrVoid *params )
 {
     // param 0: the type we are looking for
@@ -17,6 +17,7 @@
 #include "att_comparison.h"
 #include "bboxdevicecontext.h"
 #include "doc.h"
+#include "measure.h"
 #include "system.h"
 #include "view.h"
 #include "vrv.h"
@@ -42,6 +43,7 @@ void Page::Reset()
     DocObject::Reset();
     m_drawingScoreDef.Reset();
     m_layoutDone = false;
+    m_drawingLongestActualDur = DUR_1;
     this->ResetUuid();
     
     // by default we have no values and use the document ones
@@ -78,6 +80,10 @@ int Page::GetStaffPosOnPage( Staff *staff )
 void Page::LayOut( bool force )
 {
     if ( m_layoutDone && !force ) {
+        // only the measures modified since need to be laid out again - the measure breaks are kept
+        if ( this->IsModified() ) {
+            this->LayOutModified();
+        }
         return;
     }
     
@@ -86,9 +92,99 @@ void Page::LayOut( bool force )
     this->JustifyHorizontally();
     
     m_layoutDone = true;
+    this->ResetModified();
+}
+    
+bool Page::LayOutModified( )
+{
+    if ( !m_layoutDone ) {
+        this->LayOut();
+        return false;
+    }
+    
+    Doc *doc = dynamic_cast<Doc*>(m_parent);
+    assert( doc );
+    
+    // the horizontal layout kept for casting off the document is not valid anymore
+    doc->ResetCastOffLayout();
+    
+    // The modified measures have to be aligned again. The other ones keep their alignment but
+    // they need to be justified again with their system, so we restore their non justified positions.
+    // If the spacing changes because the longest duration is different, we need all of them.
+    bool allMeasures = ( !doc->GetEvenSpacing() && (this->GetLongestActualDur() != m_drawingLongestActualDur) );
+    ArrayOfObjects objects;
+    ArrayOfObjects::iterator iter;
+    int i;
+    for (iter = m_children.begin(); iter != m_children.end(); ++iter) {
+        System *system = dynamic_cast<System*>(*iter);
+        assert( system );
+        for (i = 0; i < system->GetChildCount(); i++) {
+            Object *child = system->GetChild( i );
+            Measure *measure = dynamic_cast<Measure*>(child);
+            if ( !measure ) {
+                // measures within editorial markup are not looked for
+                if ( child->IsEditorialElement() ) allMeasures = true;
+                continue;
+            }
+            if ( measure->IsModified() ) {
+                objects.push_back( measure );
+            }
+            else {
+                measure->ResetJustification();
+            }
+        }
+    }
+    // Something else than a measure was modified on the page
+    if ( objects.empty() ) {
+        allMeasures = true;
+    }
+    if ( allMeasures ) {
+        objects.clear();
+        objects.push_back( this );
+    }
+    
+    this->LayOutHorizontally( &objects );
+    
+    // Check the measure breaks in the modified systems - the next measure can be on the next page
+    bool breaksChanged = false;
+    for (iter = m_children.begin(); iter != m_children.end(); ++iter) {
+        System *system = dynamic_cast<System*>(*iter);
+        assert( system );
+        if ( !system->IsModified() ) {
+            continue;
+        }
+        Object *next = NULL;
+        if ( (iter + 1) != m_children.end() ) {
+            next = *(iter + 1);
+        }
+        else if ( this->GetIdx() + 1 < doc->GetChildCount() ) {
+            next = doc->GetChild( this->GetIdx() + 1 );
+        }
+        Measure *nextMeasure = NULL;
+        if ( next ) {
+            nextMeasure = dynamic_cast<Measure*>(next->FindChildByType( MEASURE ) );
+        }
+        if ( system->HaveMeasureBreaksChanged( nextMeasure ) ) {
+            breaksChanged = true;
+        }
+    }
+    
+    this->LayOutVertically();
+    this->JustifyHorizontally();
+    
+    this->ResetModified();
+    
+    return breaksChanged;
 }
     
-void Page::LayOutHorizontally( )
+void Page::LayOutHorizontally( int longestActualDur )
+{
+    ArrayOfObjects objects;
+    objects.push_back( this );
+    this->LayOutHorizontally( &objects, longestActualDur );
+}
+    
+void Page::LayOutHorizontally( ArrayOfObjects *objects, int longestActualDur )
 {
     Doc *doc = dynamic_cast<Doc*>(m_parent);
     assert( doc );
@@ -98,6 +194,7 @@ void Page::LayOutHorizontally( )
     assert( this == doc->GetDrawingPage() );
     
     ArrayPtrVoid params;
+    ArrayOfObjects::iterator iter;
     
     // Align the content of the page using measure aligners
     // After this:
@@ -112,21 +209,18 @@ void Page::LayOutHorizontally( )
     params.push_back( &currentMeterSig );
     Functor alignHorizontally( &Object::AlignHorizontally );
     Functor alignHorizontallyEnd( &Object::AlignHorizontallyEnd );
-    this->Process( &alignHorizontally, &params, &alignHorizontallyEnd );
+    for (iter = objects->begin(); iter != objects->end(); ++iter) {
+        (*iter)->Process( &alignHorizontally, &params, &alignHorizontallyEnd );
+    }
     
     // Unless duration-based spacing is disabled, set the X position of each Alignment.
     // Does non-linear spacing based on the duration space between two Alignment objects.
     if (!doc->GetEvenSpacing()) {
-        int longestActualDur;
         // Get the longest duration in the piece
-        AttDurExtreme durExtremeComparison(LONGEST);
-        Object *longestDur = this->FindChildExtremeByAttComparison(&durExtremeComparison);
-        if (longestDur) {
-            DurationInterface *interface = dynamic_cast<DurationInterface*>(longestDur);
-            assert(interface);
-            longestActualDur = interface->GetActualDur();
-            LogDebug("Longest duration is DUR_* code %d", longestActualDur);
+        if ( longestActualDur == VRV_UNSET ) {
+            longestActualDur = this->GetLongestActualDur();
         }
+        m_drawingLongestActualDur = longestActualDur;
 
         params.clear();
         double previousTime = 0.0;
@@ -138,7 +232,9 @@ void Page::LayOutHorizontally( )
         Functor setAlignmentX( &Object::SetAlignmentXPos );
         // Special case: because we redirect the functor, pass it a parameter to itself (!)
         params.push_back( &setAlignmentX );
-        this->Process( &setAlignmentX, &params );
+        for (iter = objects->begin(); iter != objects->end(); ++iter) {
+            (*iter)->Process( &setAlignmentX, &params );
+        }
     }
     
     // Render it for filling the bounding box
@@ -156,7 +252,9 @@ void Page::LayOutHorizontally( )
     params.push_back( &grace_min_pos );
     params.push_back( doc );
     Functor setBoundingBoxGraceXShift( &Object::SetBoundingBoxGraceXShift );
-    this->Process( &setBoundingBoxGraceXShift, &params );
+    for (iter = objects->begin(); iter != objects->end(); ++iter) {
+        (*iter)->Process( &setBoundingBoxGraceXShift, &params );
+    }
     
     // Integrate the X bounding box shift of the elements
     // Once the m_xShift have been calculated, move all positions accordingly
@@ -164,7 +262,9 @@ void Page::LayOutHorizontally( )
     Functor integrateBoundingBoxGraceXShift( &Object::IntegrateBoundingBoxGraceXShift );
     // Special case: because we redirect the functor, pass it a parameter to itself (!)
     params.push_back( &integrateBoundingBoxGraceXShift );
-    this->Process( &integrateBoundingBoxGraceXShift, &params );
+    for (iter = objects->begin(); iter != objects->end(); ++iter) {
+        (*iter)->Process( &integrateBoundingBoxGraceXShift, &params );
+    }
     
     // Adjust the X shift of the Alignment looking at the bounding boxes
     // Look at each LayerElement and changes the m_xShift if the bounding box is overlapping
@@ -176,7 +276,9 @@ void Page::LayOutHorizontally( )
     params.push_back( doc );
     Functor setBoundingBoxXShift( &Object::SetBoundingBoxXShift );
     Functor setBoundingBoxXShiftEnd( &Object::SetBoundingBoxXShiftEnd );
-    this->Process( &setBoundingBoxXShift, &params, &setBoundingBoxXShiftEnd );
+    for (iter = objects->begin(); iter != objects->end(); ++iter) {
+        (*iter)->Process( &setBoundingBoxXShift, &params, &setBoundingBoxXShiftEnd );
+    }
     
     // Integrate the X bounding box shift of the elements
     // Once the m_xShift have been calculated, move all positions accordingly
@@ -191,7 +293,9 @@ void Page::LayOutHorizontally( )
     Functor integrateBoundingBoxXShift( &Object::IntegrateBoundingBoxXShift );
     // Special case: because we redirect the functor, pass it a parameter to itself (!)
     params.push_back( &integrateBoundingBoxXShift );
-    this->Process( &integrateBoundingBoxXShift, &params );
+    for (iter = objects->begin(); iter != objects->end(); ++iter) {
+        (*iter)->Process( &integrateBoundingBoxXShift, &params );
+    }
     
     // Adjust measure X position
     params.clear();
@@ -202,6 +306,20 @@ void Page::LayOutHorizontally( )
     this->Process( &alignMeasures, &params, &alignMeasuresEnd );
 }
     
+int Page::GetLongestActualDur( )
+{
+    int longestActualDur = DUR_1;
+    AttDurExtreme durExtremeComparison(LONGEST);
+    Object *longestDur = this->FindChildExtremeByAttComparison(&durExtremeComparison);
+    if (longestDur) {
+        DurationInterface *interface = dynamic_cast<DurationInterface*>(longestDur);
+        assert(interface);
+        longestActualDur = interface->GetActualDur();
+        LogDebug("Longest duration is DUR_* code %d", longestActualDur);
+    }
+    return longestActualDur;
+}
+    
 void Page::LayOutVertically( )
 {
     Doc *doc = dynamic_cast<Doc*>(m_parent);
@@ -308,6 +426,22 @@ void Page::JustifyHorizontally( )
     this->Process( &justifyX, &params );
 }
     
+void Page::ResetModified( )
+{
+    ArrayOfObjects::iterator iter;
+    int i;
+    for (iter = m_children.begin(); iter != m_children.end(); ++iter) {
+        System *system = dynamic_cast<System*>(*iter);
+        assert( system );
+        for (i = 0; i < system->GetChildCount(); i++) {
+            Measure *measure = dynamic_cast<Measure*>(system->GetChild( i ));
+            if ( measure ) measure->Modify( false );
+        }
+        system->Modify( false );
+    }
+    this->Modify( false );
+}
+    
 int Page::GetContentHeight( )
 {
     Doc *doc = dynamic_cast<Doc*>(m_parent);
@@ -448,9 +448,11 @@ int ScoreDef::CastOffSystems( ArrayPtrVoid *params )
     // param 3: the cummulated shift (m_drawingXRel of the first measure of the current system) (unused)
     // param 4: the system width (unused)
     // param 5: the current scoreDef width
+    // param 6: the index of the previous child moved from the content system
     System *contentSystem = static_cast<System*>((*params).at(0));
     System **currentSystem = static_cast<System**>((*params).at(2));
     int *currentScoreDefWidth = static_cast<int*>((*params).at(5));
+    int *contentIdx = static_cast<int*>((*params).at(6));
     
     // Since the functor returns FUNCTOR_SIBLINGS we should never go lower than the system children
     assert( dynamic_cast<System*>(this->m_parent));
@@ -459,7 +461,9 @@ int ScoreDef::CastOffSystems( ArrayPtrVoid *params )
     // We want to move the measure to the currentSystem. However, we cannot use DetachChild
     // from the content System because this screws up the iterator. Relinquish gives up
     // the ownership of the Measure - the contentSystem will be deleted afterwards.
-    ScoreDef *scoreDef = dynamic_cast<ScoreDef*>( contentSystem->Relinquish( this->GetIdx()) );
+    // The children are processed in order, so we look for the index from the previous one.
+    (*contentIdx) = contentSystem->GetChildIndex( this, (*contentIdx) );
+    ScoreDef *scoreDef = dynamic_cast<ScoreDef*>( contentSystem->Relinquish( (*contentIdx) ) );
     (*currentSystem)->AddScoreDef( scoreDef );
     // This is not perfect since now the scoreDefWith is the one of the intermediate scoreDef (and not
     // the initial one - for this to be corrected, we would need to parameters, one for the current initial
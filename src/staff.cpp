@@ -14,6 +14,7 @@
 
 //----------------------------------------------------------------------------
 
+#include "att_comparison.h"
 #include "doc.h"
 #include "layer.h"
 #include "note.h"
@@ -252,5 +253,48 @@ int Staff::PrepareRpt( ArrayPtrVoid *params )
     (*multiNumber) = BOOLEAN_true;
     return FUNCTOR_CONTINUE;
 }
+    
+int Staff::PrepareByLayer( ArrayPtrVoid *params )
+{
+    // param 0: the MapOfPrepareLayerStates (unused)
+    // param 1: the current PrepareLayerState (unused)
+    // param 2: the current Staff
+    // param 3: the PrepareLyrics params of the current Verse (unused)
+    // param 4: the MapOfStaffUuidGenerators
+    Staff **currentStaff = static_cast<Staff**>((*params).at(2));
+    MapOfStaffUuidGenerators *uuidGenerators = static_cast<MapOfStaffUuidGenerators*>((*params).at(4));
+    
+    // Only the first staff with a given @n is processed within the parent
+    AttCommonNComparison matchStaff( STAFF, this->GetN() );
+    if ( this->HasPreviousSiblingByAttComparison( &matchStaff ) ) {
+        return FUNCTOR_SIBLINGS;
+    }
+    
+    (*currentStaff) = this;
+    
+    // The objects created for the staff (e.g., the accidentals) get their uuid from the generator of
+    // the staff, so they do not depend on the order in which the staves are processed by the threads
+    MapOfStaffUuidGenerators::iterator iter = uuidGenerators->find( this->GetN() );
+    if ( iter != uuidGenerators->end() ) {
+        UuidGenerator::SetCurrent( &iter->second );
+    }
+    
+    return FUNCTOR_CONTINUE;
+}
+    
+int Staff::PrepareStaffLists( ArrayPtrVoid *params )
+{
+    // param 0: the std::map<int, ArrayOfObjects> of the staves for each staff @n
+    std::map<int, ArrayOfObjects> *staffLists = static_cast<std::map<int, ArrayOfObjects>*>((*params).at(0));
+    
+    // Only the first staff with a given @n is processed within the parent (see Staff::PrepareByLayer)
+    AttCommonNComparison matchStaff( STAFF, this->GetN() );
+    if ( !this->HasPreviousSiblingByAttComparison( &matchStaff ) ) {
+        (*staffLists)[ this->GetN() ].push_back( this );
+    }
+    
+    // no need to go deeper
+    return FUNCTOR_SIBLINGS;
+}
 
 } // namespace vrv
@@ -0,0 +1,747 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:        streamingsvgdevicecontext.cpp
+// Author:      Laurent Pugin
+// Created:     2015
+// Copyright (c) Authors and others. All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+
+
+#include "streamingsvgdevicecontext.h"
+
+//----------------------------------------------------------------------------
+
+#include <algorithm>
+#include <assert.h>
+#include <math.h>
+
+//----------------------------------------------------------------------------
+
+#include "doc.h"
+#include "glyph.h"
+#include "pugixml.hpp"
+#include "view.h"
+#include "vrv.h"
+
+//----------------------------------------------------------------------------
+
+/**
+ * The size reserved for the content of the SVG.
+ * This avoids most of the reallocations for standard pages.
+ */
+#define STREAMING_SVG_BUFFER_SIZE 1024 * 1024
+
+namespace vrv {
+
+extern "C" {
+static inline double DegToRad(double deg) { return (deg * M_PI) / 180.0; }
+}
+
+/**
+ * A pugi::xml_writer appending to a std::string.
+ * This is used for writing the cached glyph and font definitions.
+ */
+class StringXmlWriter: public pugi::xml_writer
+{
+public:
+    StringXmlWriter( std::string *output ) { m_output = output; };
+    virtual void write( const void *data, size_t size ) { m_output->append( (const char *)data, size ); };
+private:
+    std::string *m_output;
+};
+
+//----------------------------------------------------------------------------
+// StreamingSvgDeviceContext
+//----------------------------------------------------------------------------
+
+StreamingSvgDeviceContext::StreamingSvgDeviceContext(int width, int height):
+    DeviceContext()
+{
+    m_width = width;
+    m_height = height;
+
+    m_userScaleX = 1.0;
+    m_userScaleY = 1.0;
+    m_originX = 0;
+    m_originY = 0;
+
+    SetBrush( AxBLACK, AxSOLID );
+    SetPen( AxBLACK, 1, AxSOLID );
+
+    m_smufl_glyphs.clear();
+    m_vrvTextFont = false;
+
+    m_committed = false;
+
+    // the main buffer
+    m_buffers.push_back( std::string() );
+    m_buffers[0].reserve( STREAMING_SVG_BUFFER_SIZE );
+
+    // the initial SVG element - its start tag (with width and height) is written in "commit"
+    Element svg;
+    svg.m_name = "svg";
+    svg.m_buffer = 0;
+    svg.m_depth = 0;
+    svg.m_hasChildren = true;
+    svg.m_closed = false;
+    svg.m_endPos = 0;
+    m_elements.push_back( svg );
+
+    //start the stack
+    m_elementStack.push_back( 0 );
+}
+
+
+StreamingSvgDeviceContext::~StreamingSvgDeviceContext ( )
+{
+}
+
+std::string *StreamingSvgDeviceContext::OpenChild( )
+{
+    Element *parent = &m_elements[ m_elementStack.back() ];
+    std::string *buffer = &m_buffers[ parent->m_buffer ];
+    if ( !parent->m_hasChildren ) {
+        buffer->append( ">\n" );
+        parent->m_hasChildren = true;
+    }
+    WriteIndent( buffer, parent->m_depth + 1 );
+    return buffer;
+}
+
+void StreamingSvgDeviceContext::StartElement( const char *name )
+{
+    std::string *buffer = OpenChild();
+    buffer->append( "<" );
+    buffer->append( name );
+
+    Element element;
+    element.m_name = name;
+    element.m_buffer = m_elements[ m_elementStack.back() ].m_buffer;
+    element.m_depth = m_elements[ m_elementStack.back() ].m_depth + 1;
+    element.m_hasChildren = false;
+    element.m_closed = false;
+    element.m_endPos = 0;
+    m_elements.push_back( element );
+    m_elementStack.push_back( (int)m_elements.size() - 1 );
+}
+
+void StreamingSvgDeviceContext::EndElement( )
+{
+    // never close the initial SVG element
+    if ( m_elementStack.size() < 2 ) return;
+
+    Element *element = &m_elements[ m_elementStack.back() ];
+    m_elementStack.pop_back();
+    std::string *buffer = &m_buffers[ element->m_buffer ];
+
+    element->m_endPos = buffer->size();
+    element->m_closed = true;
+    if ( !element->m_hasChildren ) {
+        buffer->append( " />\n" );
+    }
+    else {
+        WriteIndent( buffer, element->m_depth );
+        buffer->append( "</" );
+        buffer->append( element->m_name );
+        buffer->append( ">\n" );
+    }
+}
+
+void StreamingSvgDeviceContext::WriteAttribute( std::string *buffer, const char *name, const std::string &value )
+{
+    buffer->append( " " );
+    buffer->append( name );
+    buffer->append( "=\"" );
+    WriteEscaped( buffer, value, true );
+    buffer->append( "\"" );
+}
+
+void StreamingSvgDeviceContext::WriteAttribute( std::string *buffer, const char *name, int value )
+{
+    buffer->append( " " );
+    buffer->append( name );
+    buffer->append( "=\"" );
+    WriteInt( buffer, value );
+    buffer->append( "\"" );
+}
+
+void StreamingSvgDeviceContext::WriteEscaped( std::string *buffer, const std::string &value, bool attribute )
+{
+    // Same escaping as pugixml (see text_output_escaped) for having the same output
+    const char *s = value.c_str();
+    const char *end = s + value.size();
+    const char *prev = s;
+    for (; s < end; s++) {
+        unsigned char c = (unsigned char)*s;
+        if ( (c >= 32) && (c != '&') && (c != '<') && (c != '>') && ((c != '"') || !attribute) ) continue;
+        if ( c == '\t' ) continue;
+        if ( ((c == '\n') || (c == '\r')) && !attribute ) continue;
+        buffer->append( prev, s - prev );
+        prev = s + 1;
+        switch ( c ) {
+            case '&': buffer->append( "&amp;" ); break;
+            case '<': buffer->append( "&lt;" ); break;
+            case '>': buffer->append( "&gt;" ); break;
+            case '"': buffer->append( "&quot;" ); break;
+            default:
+                buffer->append( "&#" );
+                buffer->push_back( (char)('0' + c / 10) );
+                buffer->push_back( (char)('0' + c % 10) );
+                buffer->append( ";" );
+        }
+    }
+    buffer->append( prev, end - prev );
+}
+
+void StreamingSvgDeviceContext::WriteInt( std::string *buffer, int value )
+{
+    char digits[12];
+    int i = 12;
+    // use an unsigned value for INT_MIN
+    unsigned int u = ( value < 0 ) ? -(unsigned int)value : (unsigned int)value;
+    do {
+        digits[--i] = (char)('0' + u % 10);
+        u /= 10;
+    } while ( u );
+    if ( value < 0 ) digits[--i] = '-';
+    buffer->append( digits + i, 12 - i );
+}
+
+void StreamingSvgDeviceContext::WriteIndent( std::string *buffer, int depth )
+{
+    buffer->append( depth, '\t' );
+}
+
+void StreamingSvgDeviceContext::AppendBuffer( int buffer, std::string *output, std::vector<bool> *visited )
+{
+    // this should never happen unless graphics are resumed within each other
+    if ( (*visited)[buffer] ) return;
+    (*visited)[buffer] = true;
+
+    // the elements closed in the buffer with resumed content ordered by position
+    std::map<size_t, int> insertions;
+    std::vector<int>::iterator groupIter;
+    for (groupIter = m_resumedGroups.begin(); groupIter != m_resumedGroups.end(); ++groupIter) {
+        if ( (m_elements[*groupIter].m_buffer == buffer) && m_elements[*groupIter].m_closed ) {
+            insertions[ m_elements[*groupIter].m_endPos ] = *groupIter;
+        }
+    }
+
+    const std::string &content = m_buffers[buffer];
+    size_t pos = 0;
+    std::map<size_t, int>::iterator iter;
+    for (iter = insertions.begin(); iter != insertions.end(); ++iter) {
+        Element *element = &m_elements[ iter->second ];
+        output->append( content, pos, element->m_endPos - pos );
+        pos = element->m_endPos;
+        // the element was written as an empty element - replace the " />\n"
+        if ( !element->m_hasChildren ) {
+            output->append( ">\n" );
+            pos += 4;
+        }
+        std::vector<int>::iterator it;
+        for (it = element->m_resumedBuffers.begin(); it != element->m_resumedBuffers.end(); ++it) {
+            AppendBuffer( *it, output, visited );
+        }
+        if ( !element->m_hasChildren ) {
+            WriteIndent( output, element->m_depth );
+            output->append( "</" );
+            output->append( element->m_name );
+            output->append( ">\n" );
+        }
+    }
+    output->append( content, pos, std::string::npos );
+}
+
+void StreamingSvgDeviceContext::Commit( bool xml_declaration ) {
+
+    if (m_committed) {
+        return;
+    }
+
+    // close the elements that are still opened
+    while ( m_elementStack.size() > 1 ) EndElement();
+
+    m_outdata.reserve( m_buffers[0].size() + STREAMING_SVG_BUFFER_SIZE / 4 );
+
+    if (xml_declaration) {
+        m_outdata.append( "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"no\"?>\n" );
+    }
+
+    // take care of width/height once userScale is updated
+    m_outdata.append( "<svg" );
+    WriteAttribute( &m_outdata, "width", StringFormat("%dpx", (int)((double)m_width * m_userScaleX)) );
+    WriteAttribute( &m_outdata, "height", StringFormat("%dpx", (int)((double)m_height * m_userScaleY)) );
+    m_outdata.append( " version=\"1.1\" xmlns=\"http://www.w3.org/2000/svg\" xmlns:xlink=\"http://www.w3.org/1999/xlink\" overflow=\"visible\"" );
+
+    pugi::xml_node woff;
+    if (m_vrvTextFont) {
+        woff = GetResources()->GetTextFontDefinition();
+    }
+    if ( m_smufl_glyphs.empty() && !woff && m_buffers[0].empty() ) {
+        m_outdata.append( " />\n" );
+        m_committed = true;
+        return;
+    }
+    m_outdata.append( ">\n" );
+
+    StringXmlWriter writer( &m_outdata );
+
+    // header
+    if (m_smufl_glyphs.size() > 0)
+    {
+        size_t defsPos = m_outdata.size();
+        m_outdata.append( "\t<defs>\n" );
+        bool hasDefinition = false;
+        //for each needed glyph, write the definition cached by Resources
+        std::vector<Glyph*>::const_iterator it;
+        for(it = m_smufl_glyphs.begin(); it != m_smufl_glyphs.end(); ++it)
+        {
+            if ( !(*it)->GetDefinition() ) continue;
+            (*it)->GetDefinition().print( writer, "\t", pugi::format_default, pugi::encoding_auto, 2 );
+            hasDefinition = true;
+        }
+        if ( hasDefinition ) {
+            m_outdata.append( "\t</defs>\n" );
+        }
+        else {
+            m_outdata.replace( defsPos, std::string::npos, "\t<defs />\n" );
+        }
+    }
+
+    // add the woff VerovioText font in needed
+    if (woff) {
+        woff.print( writer, "\t", pugi::format_default, pugi::encoding_auto, 1 );
+    }
+
+    std::vector<bool> visited( m_buffers.size(), false );
+    AppendBuffer( 0, &m_outdata, &visited );
+
+    m_outdata.append( "</svg>\n" );
+
+    // free the buffers since everything is in the output
+    m_buffers.clear();
+
+    m_committed = true;
+}
+
+
+void StreamingSvgDeviceContext::StartGraphic( DocObject *object, std::string gClass, std::string gId )
+{
+    std::string baseClass = object->GetClassName();
+    std::transform( baseClass.begin(), baseClass.begin() + 1, baseClass.begin(), ::tolower );
+    if (gClass.length() > 0) {
+        baseClass.append(" " + gClass);
+    }
+
+    StartElement( "g" );
+    std::string *buffer = &m_buffers[ m_elements.back().m_buffer ];
+    WriteAttribute( buffer, "class", baseClass );
+    WriteAttribute( buffer, "id", gId );
+
+    // keep the first group with the id, as the XPath query in SvgDeviceContext::ResumeGraphic does
+    if ( !m_groups.count( gId ) ) {
+        m_groups[gId] = m_elementStack.back();
+    }
+}
+
+void StreamingSvgDeviceContext::ResumeGraphic( DocObject *object, std::string gId )
+{
+    std::map<std::string, int>::iterator iter = m_groups.find( gId );
+    // not found, we continue to write in the current element
+    if ( iter == m_groups.end() ) {
+        m_elementStack.push_back( m_elementStack.back() );
+        return;
+    }
+    // this is the current element, we can write in it directly
+    if ( iter->second == m_elementStack.back() ) {
+        m_elementStack.push_back( iter->second );
+        return;
+    }
+
+    // otherwise we write in a new buffer inserted at the end of the group when committing
+    m_buffers.push_back( std::string() );
+    Element *group = &m_elements[ iter->second ];
+    if ( group->m_resumedBuffers.empty() ) m_resumedGroups.push_back( iter->second );
+    group->m_resumedBuffers.push_back( (int)m_buffers.size() - 1 );
+
+    Element resumed;
+    resumed.m_name = group->m_name;
+    resumed.m_buffer = (int)m_buffers.size() - 1;
+    resumed.m_depth = group->m_depth;
+    resumed.m_hasChildren = true;
+    resumed.m_closed = false;
+    resumed.m_endPos = 0;
+    m_elements.push_back( resumed );
+    m_elementStack.push_back( (int)m_elements.size() - 1 );
+}
+
+
+void StreamingSvgDeviceContext::EndGraphic(DocObject *object, View *view )
+{
+    EndElement();
+}
+
+void StreamingSvgDeviceContext::EndResumedGraphic(DocObject *object, View *view )
+{
+    if ( m_elementStack.size() < 2 ) return;
+    m_elementStack.pop_back();
+}
+
+void StreamingSvgDeviceContext::StartPage( )
+{
+    // Initialize the flag to false because we want to know if the font needs to be included in the SVG
+    m_vrvTextFont = false;
+
+    // a graphic for definition scaling
+    StartElement( "svg" );
+    std::string *buffer = &m_buffers[ m_elements.back().m_buffer ];
+    buffer->append( " id=\"definition-scale\" viewBox=\"0 0 " );
+    WriteInt( buffer, m_width * DEFINITON_FACTOR );
+    buffer->append( " " );
+    WriteInt( buffer, m_height * DEFINITON_FACTOR );
+    buffer->append( "\"" );
+
+    // a graphic for the origin
+    StartElement( "g" );
+    buffer->append( " class=\"page-margin\" transform=\"translate(" );
+    WriteInt( buffer, m_originX );
+    buffer->append( ", " );
+    WriteInt( buffer, m_originY );
+    buffer->append( ")\" style=\"stroke: #000; stroke-opacity: 1.0; fill: #000; fill-opacity: 1.0\"" );
+}
+
+
+void StreamingSvgDeviceContext::EndPage()
+{
+    // end page-margin
+    EndElement();
+    // end definition-scale
+    EndElement();
+}
+
+void StreamingSvgDeviceContext::SetBackground( int colour, int style )
+{
+    // nothing to do, we do not handle Background
+}
+
+void StreamingSvgDeviceContext::SetBackgroundImage( void *image, double opacity )
+{
+
+}
+
+void StreamingSvgDeviceContext::SetBackgroundMode( int mode )
+{
+    // nothing to do, we do not handle Background Mode
+}
+
+void StreamingSvgDeviceContext::SetTextForeground( int colour )
+{
+    m_brushStack.top().SetColour(colour); // we use the brush colour for text
+}
+
+void StreamingSvgDeviceContext::SetTextBackground( int colour )
+{
+    // nothing to do, we do not handle Text Background Mode
+}
+
+void StreamingSvgDeviceContext::SetLogicalOrigin( int x, int y )
+{
+    m_originX = -x;
+    m_originY = -y;
+}
+
+void StreamingSvgDeviceContext::SetUserScale( double xScale, double yScale )
+{
+    m_userScaleX = xScale;
+    m_userScaleY = yScale;
+}
+
+Point StreamingSvgDeviceContext::GetLogicalOrigin( )
+{
+    return Point( m_originX, m_originY );
+}
+
+// Drawing mething
+void StreamingSvgDeviceContext::DrawComplexBezierPath(int x, int y, int bezier1_coord[6], int bezier2_coord[6])
+{
+    std::string *buffer = OpenChild();
+    buffer->append( "<path d=\"M" );
+    WriteInt( buffer, x );
+    buffer->append( "," );
+    WriteInt( buffer, y );
+    int i;
+    for (i = 0; i < 6; i++) {
+        buffer->append( (i == 0) ? " C" : ((i % 2) ? "," : " ") );
+        WriteInt( buffer, bezier1_coord[i] );
+    }
+    for (i = 0; i < 6; i++) {
+        buffer->append( (i == 0) ? " C" : ((i % 2) ? "," : " ") );
+        WriteInt( buffer, bezier2_coord[i] );
+    }
+    buffer->append( "\" style=\"fill-opacity:1.0; stroke-linecap:round; stroke-linejoin:round; stroke-opacity:1.0; stroke-width: " );
+    WriteInt( buffer, m_penStack.top().GetWidth() );
+    buffer->append( "\" />\n" );
+}
+
+void StreamingSvgDeviceContext::DrawCircle(int x, int y, int radius)
+{
+    DrawEllipse(x - radius, y - radius, 2*radius, 2*radius);
+}
+
+
+void StreamingSvgDeviceContext::DrawEllipse(int x, int y, int width, int height)
+{
+    assert( m_penStack.size() );
+    assert( m_brushStack.size() );
+
+    Pen currentPen = m_penStack.top();
+    Brush currentBrush = m_brushStack.top();
+
+    int rh = height / 2;
+    int rw = width  / 2;
+
+    std::string *buffer = OpenChild();
+    buffer->append( "<ellipse" );
+    WriteAttribute( buffer, "cx", x+rw );
+    WriteAttribute( buffer, "cy", y+rh );
+    WriteAttribute( buffer, "rx", rw );
+    WriteAttribute( buffer, "ry", rh );
+    WriteAttribute( buffer, "style", StringFormat("stroke-opacity: %f; stroke-width: %d; fill-opacity: %f;", currentPen.GetOpacity(), currentPen.GetWidth(), currentBrush.GetOpacity()) );
+    buffer->append( " />\n" );
+}
+
+
+void StreamingSvgDeviceContext::DrawEllipticArc(int x, int y, int width, int height, double start, double end)
+{
+    // See SvgDeviceContext::DrawEllipticArc
+    assert( m_penStack.size() );
+    assert( m_brushStack.size() );
+
+    Pen currentPen = m_penStack.top();
+    Brush currentBrush = m_brushStack.top();
+
+    //radius
+    double rx = width / 2 ;
+    double ry = height / 2 ;
+    // center
+    double xc = x + rx ;
+    double yc = y + ry ;
+
+    double xs, ys, xe, ye ;
+    xs = xc + rx * cos (DegToRad(start)) ;
+    xe = xc + rx * cos (DegToRad(end)) ;
+    ys = yc - ry * sin (DegToRad(start)) ;
+    ye = yc - ry * sin (DegToRad(end)) ;
+
+    ///now same as circle arc...
+    double theta1 = atan2(ys-yc, xs-xc);
+    double theta2 = atan2(ye-yc, xe-xc);
+
+    int fArc  ;
+    // flag for large or small arc 0 means less than 180 degrees
+    if ( (theta2 - theta1) > 0 ) fArc = 1; else fArc = 0 ;
+
+    int fSweep ;
+    if ( fabs(theta2 - theta1) > M_PI) fSweep = 1; else fSweep = 0 ;
+
+    std::string *buffer = OpenChild();
+    buffer->append( "<path" );
+    WriteAttribute( buffer, "d", StringFormat("M%d %d A%d %d 0.0 %d %d %d %d",int(xs), int(ys), abs(int(rx)), abs(int(ry)), fArc, fSweep, int(xe), int(ye)) );
+    WriteAttribute( buffer, "style", StringFormat("stroke-opacity: %f; stroke-width: %d; fill-opacity: %f;", currentPen.GetOpacity(), currentPen.GetWidth(), currentBrush.GetOpacity()) );
+    buffer->append( " />\n" );
+}
+
+
+void StreamingSvgDeviceContext::DrawLine(int x1, int y1, int x2, int y2)
+{
+    std::string *buffer = OpenChild();
+    buffer->append( "<path d=\"M" );
+    WriteInt( buffer, x1 );
+    buffer->append( " " );
+    WriteInt( buffer, y1 );
+    buffer->append( " L" );
+    WriteInt( buffer, x2 );
+    buffer->append( " " );
+    WriteInt( buffer, y2 );
+    buffer->append( "\" style=\"stroke-width: " );
+    WriteInt( buffer, m_penStack.top().GetWidth() );
+    buffer->append( ";\" />\n" );
+}
+
+
+void StreamingSvgDeviceContext::DrawPolygon(int n, Point points[], int xoffset, int yoffset, int fill_style)
+{
+    assert( m_penStack.size() );
+
+    std::string *buffer = OpenChild();
+    buffer->append( "<polygon style=\"fill-rule:nonzero;\"" );
+    WriteAttribute( buffer, "stroke-width", m_penStack.top().GetWidth() );
+    buffer->append( " points=\"" );
+    for (int i = 0; i < n;  i++)
+    {
+        WriteInt( buffer, points[i].x + xoffset );
+        buffer->append( "," );
+        WriteInt( buffer, points[i].y + yoffset );
+        buffer->append( " " );
+    }
+    buffer->append( "\" />\n" );
+}
+
+
+void StreamingSvgDeviceContext::DrawRectangle(int x, int y, int width, int height)
+{
+    DrawRoundedRectangle( x, y, width, height, 0 );
+}
+
+
+void StreamingSvgDeviceContext::DrawRoundedRectangle(int x, int y, int width, int height, double radius)
+{
+    // negative heights or widths are not allowed in SVG
+    if ( height < 0 ) {
+        height = -height;
+        y -= height;
+    }
+     if ( width < 0 ) {
+        width = -width;
+        x -= width;
+    }
+
+    std::string *buffer = OpenChild();
+    buffer->append( "<rect" );
+    WriteAttribute( buffer, "x", x );
+    WriteAttribute( buffer, "y", y );
+    WriteAttribute( buffer, "width", width );
+    WriteAttribute( buffer, "height", height );
+    // same formatting as pugixml for doubles
+    WriteAttribute( buffer, "rx", StringFormat("%g", radius) );
+    buffer->append( " style=\"stroke-width: " );
+    WriteInt( buffer, m_penStack.top().GetWidth() );
+    buffer->append( ";\" />\n" );
+}
+
+void StreamingSvgDeviceContext::StartText(int x, int y, char alignement)
+{
+    std::string anchor;
+
+    if ( alignement == RIGHT ) {
+        anchor = "end";
+    }
+    if ( alignement == CENTER ) {
+        anchor = "middle";
+    }
+
+    StartElement( "text" );
+    std::string *buffer = &m_buffers[ m_elements.back().m_buffer ];
+    WriteAttribute( buffer, "x", x );
+    WriteAttribute( buffer, "y", y );
+    buffer->append( " dx=\"0\" dy=\"0\"" );
+    if ( !anchor.empty() ) {
+        WriteAttribute( buffer, "text-anchor", anchor );
+    }
+    // see SvgDeviceContext::StartText for the font-size
+    buffer->append( " font-size=\"0px\"" );
+}
+
+void StreamingSvgDeviceContext::EndText()
+{
+    EndElement();
+}
+
+void StreamingSvgDeviceContext::DrawText(const std::string& text, const std::wstring wtext)
+{
+    assert( m_fontStack.top() );
+
+    std::string *buffer = OpenChild();
+    buffer->append( "<tspan" );
+    if ( !m_fontStack.top()->GetFaceName().empty() ) {
+        WriteAttribute( buffer, "font-family", m_fontStack.top()->GetFaceName() );
+    }
+    if ( m_fontStack.top()->GetPointSize() != 0 ) {
+        buffer->append( " font-size=\"" );
+        WriteInt( buffer, m_fontStack.top()->GetPointSize() );
+        buffer->append( "px\"" );
+    }
+    if ( m_fontStack.top()->GetStyle() != FONTWEIGHT_NONE ) {
+        if ( m_fontStack.top()->GetStyle() == FONTSTYLE_italic ) {
+            buffer->append( " font-style=\"italic\"" );
+        }
+        else if ( m_fontStack.top()->GetStyle() == FONTSTYLE_normal ) {
+            buffer->append( " font-style=\"normal\"" );
+        }
+        else if ( m_fontStack.top()->GetStyle() == FONTSTYLE_oblique ) {
+            buffer->append( " font-style=\"oblique\"" );
+        }
+    }
+    buffer->append( ">" );
+    WriteEscaped( buffer, text, false );
+    buffer->append( "</tspan>\n" );
+}
+
+
+void StreamingSvgDeviceContext::DrawRotatedText(const std::string& text, int x, int y, double angle)
+{
+    // TODO
+}
+
+void StreamingSvgDeviceContext::DrawMusicText(const std::wstring& text, int x, int y)
+{
+    assert( m_fontStack.top() );
+
+    int w, h, gx, gy;
+
+    // print chars one by one
+    for (unsigned int i = 0; i < text.length(); i++)
+    {
+        wchar_t c = text[i];
+        Glyph *glyph = GetResources()->GetGlyph(c);
+        if (!glyph)
+        {
+            continue;
+        }
+
+        // Add the glyph to the array for the <defs>
+        std::vector<Glyph*>::const_iterator it = std::find(m_smufl_glyphs.begin(), m_smufl_glyphs.end(), glyph);
+        if (it == m_smufl_glyphs.end())
+        {
+            m_smufl_glyphs.push_back( glyph );
+        }
+
+        // Write the char in the SVG
+        std::string *buffer = OpenChild();
+        buffer->append( "<use xlink:href=\"#" );
+        WriteEscaped( buffer, glyph->GetCodeStr(), true );
+        buffer->append( "\"" );
+        WriteAttribute( buffer, "x", x );
+        WriteAttribute( buffer, "y", y );
+        buffer->append( " height=\"" );
+        WriteInt( buffer, m_fontStack.top()->GetPointSize() );
+        buffer->append( "px\" width=\"" );
+        WriteInt( buffer, m_fontStack.top()->GetPointSize() );
+        buffer->append( "px\" />\n" );
+
+        // Get the bounds of the char
+        glyph->GetBoundingBox(&gx, &gy, &w, &h);
+        x += w * m_fontStack.top()->GetPointSize() / glyph->GetUnitsPerEm();
+    }
+}
+
+
+void StreamingSvgDeviceContext::DrawSpline(int n, Point points[])
+{
+
+}
+
+void StreamingSvgDeviceContext::DrawBackgroundImage( int x, int y )
+{
+
+}
+
+std::string StreamingSvgDeviceContext::GetStringSVG( bool xml_declaration )
+{
+    if (!m_committed)
+        Commit( xml_declaration );
+
+    return m_outdata;
+}
+
+} // namespace vrv
@@ -100,10 +100,7 @@ void SvgDeviceContext::Commit( bool xml_declaration ) {
     
     // add the woff VerovioText font in needed
     if (m_vrvTextFont) {
-        std::string woff = Resources::GetPath() + "/woff.xml";
-        pugi::xml_document woffDoc;
-        woffDoc.load_file(woff.c_str());
-        m_svgNode.prepend_copy( woffDoc.first_child() );
+        m_svgNode.prepend_copy( GetResources()->GetTextFontDefinition() );
     }
 
     // header
@@ -111,21 +108,12 @@ void SvgDeviceContext::Commit( bool xml_declaration ) {
     {
         
         pugi::xml_node defs = m_svgNode.prepend_child( "defs" );
-        pugi::xml_document sourceDoc;
         
-        //for each needed glyph
-        std::vector<std::string>::const_iterator it;
+        //for each needed glyph, copy the definition cached by Resources into the master document
+        std::vector<Glyph*>::const_iterator it;
         for(it = m_smufl_glyphs.begin(); it != m_smufl_glyphs.end(); ++it)
         {
-            //load the XML file that contains it as a pugi::xml_document
-            std::ifstream source( (*it).c_str() );
-            sourceDoc.load(source);
-            
-            //copy all the nodes inside into the master document
-            for (pugi::xml_node child = sourceDoc.first_child(); child; child = child.next_sibling())
-            {
-                defs.append_copy(child);
-            }
+            if ( (*it)->GetDefinition() ) defs.append_copy( (*it)->GetDefinition() );
         }
     }
     
@@ -161,15 +149,18 @@ void SvgDeviceContext::StartGraphic( DocObject *object, std::string gClass, std:
     m_svgNodeStack.push_back(m_currentNode);
     m_currentNode.append_attribute( "class" ) = baseClass.c_str();
     m_currentNode.append_attribute( "id" ) = gId.c_str();
+    // keep the first group with the id, as an XPath query on the document would return
+    if ( !m_groups.count( gId ) ) {
+        m_groups[gId] = m_currentNode;
+    }
     //m_currentNode.append_attribute( "style" ) = StringFormat("stroke: #%s; stroke-opacity: %f; fill: #%s; fill-opacity: %f;", GetColour(currentPen.GetColour()).c_str(), currentPen.GetOpacity(), GetColour(currentBrush.GetColour()).c_str(), currentBrush.GetOpacity()).c_str();
 }
     
 void SvgDeviceContext::ResumeGraphic( DocObject *object, std::string gId )
 {
-    std::string xpath = "//g[@id=\"" + gId + "\"]";
-    pugi::xpath_node selection = m_currentNode.select_single_node( xpath.c_str() );
-    if ( selection ) {
-        m_currentNode = selection.node();
+    std::map<std::string, pugi::xml_node>::iterator iter = m_groups.find( gId );
+    if ( iter != m_groups.end() ) {
+        m_currentNode = iter->second;
     }
     m_svgNodeStack.push_back(m_currentNode);
 }
@@ -539,19 +530,17 @@ void SvgDeviceContext::DrawMusicText(const std::wstring& text, int x, int y)
     for (unsigned int i = 0; i < text.length(); i++)
     {
         wchar_t c = text[i];
-        Glyph *glyph = Resources::GetGlyph(c);
+        Glyph *glyph = GetResources()->GetGlyph(c);
         if (!glyph)
         {
             continue;
         }
         
-        std::string path = glyph->GetPath();
-        
         // Add the glyph to the array for the <defs>
-        std::vector<std::string>::const_iterator it = std::find(m_smufl_glyphs.begin(), m_smufl_glyphs.end(), path);
+        std::vector<Glyph*>::const_iterator it = std::find(m_smufl_glyphs.begin(), m_smufl_glyphs.end(), glyph);
         if (it == m_smufl_glyphs.end())
         {
-            m_smufl_glyphs.push_back( path );
+            m_smufl_glyphs.push_back( glyph );
         }
         
         
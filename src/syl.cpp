@@ -10,9 +10,11 @@
 
 //----------------------------------------------------------------------------
 
+#include <assert.h>
 
 //----------------------------------------------------------------------------
 
+#include "att_comparison.h"
 #include "note.h"
 #include "verse.h"
 #include "staff.h"
@@ -98,6 +100,39 @@ int Syl::PrepareLyrics( ArrayPtrVoid *params )
     return FUNCTOR_CONTINUE;
 }
     
+int Syl::PrepareByLayer( ArrayPtrVoid *params )
+{
+    // param 0: the MapOfPrepareLayerStates (unused)
+    // param 1: the current PrepareLayerState
+    // param 2: the current Staff (unused)
+    // param 3: the PrepareLyrics params of the current Verse
+    // param 4: the MapOfStaffUuidGenerators (unused)
+    PrepareLayerState **currentState = static_cast<PrepareLayerState**>((*params).at(1));
+    ArrayPtrVoid **currentLyricsParams = static_cast<ArrayPtrVoid**>((*params).at(3));
+    
+    if ( !(*currentState) ) {
+        return FUNCTOR_CONTINUE;
+    }
+    
+    if ( (*currentLyricsParams) ) {
+        this->PrepareLyrics( *currentLyricsParams );
+        return FUNCTOR_CONTINUE;
+    }
+    
+    // The syl is not within a verse - process it for every verse of the layer but the ones
+    // already processed in the parent (only the first child matching a verse @n is processed)
+    std::map<int, ArrayPtrVoid>::iterator iter;
+    for (iter = (*currentState)->m_lyricsParams.begin(); iter != (*currentState)->m_lyricsParams.end(); ++iter) {
+        AttCommonNComparison matchVerse( VERSE, iter->first );
+        if ( this->HasPreviousSiblingByAttComparison( &matchVerse ) ) {
+            continue;
+        }
+        this->PrepareLyrics( &iter->second );
+    }
+    
+    return FUNCTOR_CONTINUE;
+}
+    
 int Syl::FillStaffCurrentTimeSpanning( ArrayPtrVoid *params )
 {
     // Pass it to the pseudo functor of the interface
@@ -54,6 +54,7 @@ void System::Reset()
     m_drawingTotalWidth = 0;
     m_drawingLabelsWidth = 0;
     m_drawingAbbrLabelsWidth = 0;
+    m_drawingCastOffWidth = VRV_UNSET;
 }
 
 void System::AddMeasure( Measure *measure )
@@ -112,6 +113,28 @@ void System::SetDrawingAbbrLabelsWidth( int width )
     }
 }
     
+bool System::HaveMeasureBreaksChanged( Measure *nextMeasure )
+{
+    if ( m_drawingCastOffWidth == VRV_UNSET ) {
+        return false;
+    }
+    
+    // Too narrow for the last measure - this does not matter with only one measure since it cannot be broken
+    Measure *lastMeasure = dynamic_cast<Measure*>(this->FindChildByType( MEASURE, 1, BACKWARD ) );
+    if ( lastMeasure && (this->GetChildCount( MEASURE ) > 1)
+        && (lastMeasure->m_drawingXRel + lastMeasure->GetWidth() > m_drawingCastOffWidth) ) {
+        return true;
+    }
+    
+    // Wide enough for the next measure, which would be at the end position given by System::AlignMeasuresEnd
+    if ( nextMeasure
+        && (m_drawingTotalWidth - this->GetDrawingLabelsWidth() + nextMeasure->GetNonJustifiedWidth() <= m_drawingCastOffWidth) ) {
+        return true;
+    }
+    
+    return false;
+}
+    
 //----------------------------------------------------------------------------
 // System functor methods
 //----------------------------------------------------------------------------
@@ -254,11 +277,13 @@ int System::CastOffPages( ArrayPtrVoid *params )
     // param 2: a pointer to the current page
     // param 3: the cummulated shift (m_drawingYRel of the first system of the current page)
     // param 4: the page height
+    // param 5: the index of the previous system moved from the content page
     Page *contentPage = static_cast<Page*>((*params).at(0));
     Doc *doc = static_cast<Doc*>((*params).at(1));
     Page **currentPage = static_cast<Page**>((*params).at(2));
     int *shift = static_cast<int*>((*params).at(3));
     int *pageHeight = static_cast<int*>((*params).at(4));
+    int *contentIdx = static_cast<int*>((*params).at(5));
     
     if ( ( (*currentPage)->GetChildCount() > 0 ) && ( this->m_drawingYRel - this->GetHeight() - (*shift) < 0 )) { //(*pageHeight) ) ) {
         (*currentPage) = new Page();
@@ -270,7 +295,9 @@ int System::CastOffPages( ArrayPtrVoid *params )
     // We want to move the system to the currentPage. However, we cannot use DetachChild
     // from the contentPage because this screws up the iterator. Relinquish gives up
     // the ownership of the system - the contentPage itself will be deleted afterwards.
-    System *system = dynamic_cast<System*>( contentPage->Relinquish( this->GetIdx()) );
+    // The systems are processed in order, so we look for the index from the previous one.
+    (*contentIdx) = contentPage->GetChildIndex( this, (*contentIdx) );
+    System *system = dynamic_cast<System*>( contentPage->Relinquish( (*contentIdx) ) );
     (*currentPage)->AddSystem( system );
     
     return FUNCTOR_SIBLINGS;
@@ -105,10 +105,14 @@ std::string TimeSpanningInterface::ExtractUuidFragment(std::string refUuid)
    
 int TimeSpanningInterface::InterfacePrepareTimeSpanning( ArrayPtrVoid *params, DocObject *object )
 {
-    // param 0: std::vector<DocObject*>* that holds the current elements to match
+    // param 0: std::vector<DocObject*>* that holds all the elements to match
     // param 1: bool* fillList for indicating whether the elements have to be stack or not
+    // param 2: MapOfUuidTimeSpanningInterfaces* of the elements with a start still to match
+    // param 3: MapOfUuidTimeSpanningInterfaces* of the elements with an end still to match
     std::vector<DocObject*> *elements = static_cast<std::vector<DocObject*>*>((*params).at(0));
     bool *fillList = static_cast<bool*>((*params).at(1));
+    MapOfUuidTimeSpanningInterfaces *starts = static_cast<MapOfUuidTimeSpanningInterfaces*>((*params).at(2));
+    MapOfUuidTimeSpanningInterfaces *ends = static_cast<MapOfUuidTimeSpanningInterfaces*>((*params).at(3));
     
     if ((*fillList)==false) {
         return FUNCTOR_CONTINUE;
@@ -116,6 +120,13 @@ int TimeSpanningInterface::InterfacePrepareTimeSpanning( ArrayPtrVoid *params, D
     
     this->SetUuidStr();
     elements->push_back(object);
+    // Without uuid, the start or end cannot be matched
+    if ( !m_startUuid.empty() ) {
+        (*starts)[m_startUuid].push_back( this );
+    }
+    if ( !m_endUuid.empty() ) {
+        (*ends)[m_endUuid].push_back( this );
+    }
     
     return FUNCTOR_CONTINUE;
 }
@@ -10,7 +10,17 @@
 
 //----------------------------------------------------------------------------
 
+#include <algorithm>
 #include <assert.h>
+#include <fcntl.h>
+#include <map>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef USE_EMSCRIPTEN
+#include "jsonxx.h"
+#endif
 
 //----------------------------------------------------------------------------
 
@@ -23,6 +33,7 @@
 #include "measure.h"
 #include "note.h"
 #include "slur.h"
+#include "streamingsvgdevicecontext.h"
 #include "svgdevicecontext.h"
 #include "style.h"
 #include "vrv.h"
@@ -32,6 +43,48 @@ namespace vrv {
 const char *UTF_16_BE_BOM = "\xFE\xFF";
 const char *UTF_16_LE_BOM = "\xFF\xFE";
     
+//----------------------------------------------------------------------------
+// MappedFile
+//----------------------------------------------------------------------------
+
+/**
+ * This class maps a file in memory for LoadFile.
+ * The mapping is private, so the buffer can be parsed in place without changing the file.
+ * The file is unmapped when the object is destroyed.
+ */
+class MappedFile
+{
+public:
+    MappedFile( const std::string &filename ) 
+    {
+        m_data = NULL;
+        m_size = 0;
+        int fd = open( filename.c_str(), O_RDONLY );
+        if ( fd == -1 ) {
+            return;
+        }
+        struct stat st;
+        if ( (fstat( fd, &st ) == 0) && (st.st_size > 0) ) {
+            void *data = mmap( NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0 );
+            if ( data != MAP_FAILED ) {
+                m_data = static_cast<char*>( data );
+                m_size = st.st_size;
+            }
+        }
+        close( fd );
+    }
+    
+    ~MappedFile()
+    {
+        if ( m_data ) {
+            munmap( m_data, m_size );
+        }
+    }
+    
+    char *m_data;
+    size_t m_size;
+};
+    
 //----------------------------------------------------------------------------
 // Toolkit
 //----------------------------------------------------------------------------
@@ -50,6 +103,8 @@ Toolkit::Toolkit( bool initFont )
     m_spacingNonLinear = DEFAULT_SPACING_NON_LINEAR;
     m_spacingStaff = DEFAULT_SPACING_STAFF;
     m_spacingSystem = DEFAULT_SPACING_SYSTEM;
+    m_threads = 1;
+    m_uuidSeed = -1;
     
     m_noLayout = false;
     m_ignoreLayout = false;
@@ -57,12 +112,14 @@ Toolkit::Toolkit( bool initFont )
     m_noJustification = false;
     m_evenNoteSpacing = false;
     m_showBoundingBoxes = false;
+    m_streamingSvg = false;
+    m_progressiveLayout = false;
     m_scoreBasedMei = false;
     
     m_cString = NULL;
     
     if ( initFont ) {
-        Resources::InitFonts();
+        m_doc.GetResources()->InitFonts();
     }
 }
 
@@ -76,8 +133,8 @@ Toolkit::~Toolkit()
     
 bool Toolkit::SetResourcePath( const std::string &path )
 {
-    Resources::SetPath( path );
-    return Resources::InitFonts();
+    m_doc.GetResources()->SetPath( path );
+    return m_doc.GetResources()->InitFonts();
 };
 
 bool Toolkit::SetBorder( int border )
@@ -161,6 +218,26 @@ bool Toolkit::SetSpacingNonLinear( float spacingNonLinear )
     return true;
 }
 
+bool Toolkit::SetUuidSeed( int uuidSeed )
+{
+    if (uuidSeed < 0) {
+        LogError( "The seed of the uuids has to be positive or 0" );
+        return false;
+    }
+    m_uuidSeed = uuidSeed;
+    return true;
+}
+
+bool Toolkit::SetThreads( int threads )
+{
+    if (threads < 1) {
+        LogError( "The number of threads has to be greater than 0" );
+        return false;
+    }
+    m_threads = threads;
+    return true;
+}
+
 bool Toolkit::SetFormat( std::string const &informat )
 {
     if (informat == "pae")
@@ -181,43 +258,51 @@ bool Toolkit::SetFormat( std::string const &informat )
 
 bool Toolkit::SetFont( std::string const &font )
 {
-    return Resources::SetFont(font);
+    // the glyph widths change
+    m_doc.ResetCastOffLayout();
+    return m_doc.GetResources()->SetFont(font);
 };
 
 bool Toolkit::LoadFile( const std::string &filename )
 {
-    if ( IsUTF16( filename ) ) {
-        return LoadUTF16File( filename );
+    std::string content;
+    MappedFile file( filename );
+    char *buffer = file.m_data;
+    size_t size = file.m_size;
+    // the file could not be mapped (e.g., empty file or pipe) - read it into a string:
+    if ( !buffer ) {
+        std::ifstream in( filename.c_str() );
+        if (!in.is_open()) {
+            return false;
+        }
+        content.assign( std::istreambuf_iterator<char>( in ), std::istreambuf_iterator<char>() );
+        content.push_back( 0 );
+        buffer = &content[0];
+        size = content.size() - 1;
     }
     
-    std::ifstream in( filename.c_str() );
-    if (!in.is_open()) {
-        return false;
+    if ( IsUTF16( buffer, size ) ) {
+        return LoadUTF16Data( buffer, size );
     }
     
-    in.seekg(0, std::ios::end);
-    std::streamsize fileSize = (std::streamsize)in.tellg();
-    in.clear();
-    in.seekg(0, std::ios::beg);
+    FileInputStream *input = this->CreateInput();
+    if ( !input ) {
+        return false;
+    }
     
-    // read the file into the string:
-    std::string content( fileSize, 0 );
-    in.read(&content[0], fileSize);
+    // load the file - the buffer is unmapped only when we return
+    if ( !input->ImportBuffer( buffer, size )) {
+        LogError( "Error importing file '%s'", filename.c_str() );
+        delete input;
+        return false;
+    }
     
-    return LoadString( content );
+    return this->LoadInput( input );
 }
  
-bool Toolkit::IsUTF16( const std::string &filename )
+bool Toolkit::IsUTF16( const char *data, size_t size )
 {
-    std::ifstream fin(filename.c_str(), std::ios::in | std::ios::binary);
-    if (!fin.is_open()) {
-        return false;
-    }
-    
-    char data[2];
-    memset( data, 0, 2 );
-    fin.read( data, 2 );
-    fin.close();
+    if ( size < 2 ) return false;
     
     if (memcmp(data, UTF_16_LE_BOM, 2) == 0) return true;
     if (memcmp(data, UTF_16_BE_BOM, 2) == 0) return true;
@@ -225,41 +310,49 @@ bool Toolkit::IsUTF16( const std::string &filename )
     return false;
 }
     
-bool Toolkit::LoadUTF16File( const std::string &filename )
+bool Toolkit::LoadUTF16Data( const char *data, size_t size )
 {
-    /// Loading a UTF-16 file with basic conversion ot UTF-8
-    /// This is called after checking if the file has a UTF-16 BOM
+    /// Loading UTF-16 data with conversion to UTF-8
+    /// This is called after checking if the data has a UTF-16 BOM
     
-    LogWarning("The file seems to be UTF-16 - trying to convert to UTF-8");
+    LogWarning("The data seems to be UTF-16 - trying to convert to UTF-8");
     
-    std::ifstream fin(filename.c_str(), std::ios::in | std::ios::binary);
-    if (!fin.is_open()) {
+    std::string utf8;
+    if ( !UTF16BufferTo8( data, size, &utf8 ) ) {
+        LogError( "The data is not valid UTF-16" );
         return false;
     }
     
-    fin.seekg(0, std::ios::end);
-    std::streamsize wfileSize = (std::streamsize)fin.tellg();
-    fin.clear();
-    fin.seekg(0, std::wios::beg);
-    
-    std::vector<unsigned short> utf16line;
-    utf16line.reserve(wfileSize / 2 + 1);
+    return LoadString( utf8 );
+}
+
+bool Toolkit::LoadString( const std::string &data )
+{
+    if ( IsUTF16( data.c_str(), data.size() ) ) {
+        return LoadUTF16Data( data.c_str(), data.size() );
+    }
     
-    unsigned short buffer;
-    while(fin.read((char *)&buffer, sizeof(unsigned short)))
-    {
-        utf16line.push_back(buffer);
+    FileInputStream *input = this->CreateInput();
+    if ( !input ) {
+        return false;
     }
-    //LogDebug("%d %d", wfileSize, utf8line.size());
     
-    std::string utf8line;
-    utf8::utf16to8(utf16line.begin(), utf16line.end(), back_inserter(utf8line));
+    // load the data
+    if ( !input->ImportString( data )) {
+        LogError( "Error importing data" );
+        delete input;
+        return false;
+    }
     
-    return LoadString( utf8line );
+    return this->LoadInput( input );
 }
-
-bool Toolkit::LoadString( const std::string &data )
+    
+FileInputStream *Toolkit::CreateInput( )
 {
+    if ( m_uuidSeed >= 0 ) {
+        m_doc.SetUuidSeed( (unsigned int)m_uuidSeed );
+    }
+    
     FileInputStream *input = NULL;
     if (m_format == PAE) {
         input = new PaeInput( &m_doc, "" );
@@ -273,13 +366,13 @@ bool Toolkit::LoadString( const std::string &data )
     }
     else {
         LogError( "Unknown format" );
-        return false;
+        return NULL;
     }
     
     // something went wrong
     if ( !input ) {
         LogError( "Unknown error" );
-        return false;
+        return NULL;
     }
     
     // ignore layout?
@@ -292,13 +385,11 @@ bool Toolkit::LoadString( const std::string &data )
         input->SetRdgXPathQuery( m_rdgXPathQuery );
     }
     
-    // load the file
-    if ( !input->ImportString( data )) {
-        LogError( "Error importing data" );
-        delete input;
-        return false;
-    }
+    return input;
+}
     
+bool Toolkit::LoadInput( FileInputStream *input )
+{
     m_doc.SetPageHeight( this->GetPageHeight() );
     m_doc.SetPageWidth( this->GetPageWidth() );
     m_doc.SetPageRightMar( this->GetBorder() );
@@ -309,6 +400,7 @@ bool Toolkit::LoadString( const std::string &data )
     m_doc.SetSpacingStaff( this->GetSpacingStaff() );
     m_doc.SetSpacingSystem( this->GetSpacingSystem() );
     m_doc.SetEvenSpacing( this->GetEvenNoteSpacing() );
+    m_doc.SetPrepareDrawingThreads( this->GetThreads() );
     
     m_doc.PrepareDrawing();
     
@@ -324,7 +416,7 @@ bool Toolkit::LoadString( const std::string &data )
     // was set, though.
     if (!input->HasLayoutInformation() && !m_noLayout) {
         //LogElapsedTimeStart();
-        m_doc.CastOff();
+        m_doc.CastOff( m_progressiveLayout );
         //LogElapsedTimeEnd("layout");
     }
     
@@ -338,10 +430,46 @@ bool Toolkit::LoadString( const std::string &data )
     
     return true;
 }
+    
+void Toolkit::CopyOptions( Toolkit *toolkit )
+{
+    m_scale = toolkit->m_scale;
+    m_format = toolkit->m_format;
+    m_pageHeight = toolkit->m_pageHeight;
+    m_pageWidth = toolkit->m_pageWidth;
+    m_border = toolkit->m_border;
+    m_spacingStaff = toolkit->m_spacingStaff;
+    m_spacingSystem = toolkit->m_spacingSystem;
+    m_noLayout = toolkit->m_noLayout;
+    m_ignoreLayout = toolkit->m_ignoreLayout;
+    m_adjustPageHeight = toolkit->m_adjustPageHeight;
+    m_rdgXPathQuery = toolkit->m_rdgXPathQuery;
+    m_scoreBasedMei = toolkit->m_scoreBasedMei;
+    m_evenNoteSpacing = toolkit->m_evenNoteSpacing;
+    m_spacingLinear = toolkit->m_spacingLinear;
+    m_spacingNonLinear = toolkit->m_spacingNonLinear;
+    m_threads = toolkit->m_threads;
+    m_uuidSeed = toolkit->m_uuidSeed;
+    m_noJustification = toolkit->m_noJustification;
+    m_showBoundingBoxes = toolkit->m_showBoundingBoxes;
+    m_streamingSvg = toolkit->m_streamingSvg;
+    m_progressiveLayout = toolkit->m_progressiveLayout;
+    // the path and the fonts, which are shared once loaded
+    (*m_doc.GetResources()) = (*toolkit->m_doc.GetResources());
+}
 
 
 std::string Toolkit::GetMEI( int pageNo, bool scoreBased )
 {
+    // All the pages are needed when the whole document is written
+    this->ContinueLayout( std::max( pageNo, 0 ) );
+    
+    // The page count is exact only now that the page is cast off
+    if ( pageNo > m_doc.GetPageCount() ) {
+        LogError( "The page requested (%d) is not in the page range (max is %d)", pageNo, m_doc.GetPageCount() );
+        return "";
+    }
+    
     // Page number is one-based - correction to 0-based first
     pageNo--;
     
@@ -353,6 +481,8 @@ std::string Toolkit::GetMEI( int pageNo, bool scoreBased )
 
 bool Toolkit::SaveFile( const std::string &filename )
 {
+    this->ContinueLayout();
+    
     MeiOutput meioutput( &m_doc, filename.c_str());
     meioutput.SetScoreBasedMEI( m_scoreBasedMei );
     if (!meioutput.ExportFile()) {
@@ -425,6 +555,18 @@ bool Toolkit::ParseOptions( const std::string &json_options ) {
     if (json.has<jsonxx::Number>("showBoundingBoxes"))
         SetShowBoundingBoxes(json.get<jsonxx::Number>("showBoundingBoxes"));
     
+    if (json.has<jsonxx::Number>("streamingSvg"))
+        SetStreamingSvg(json.get<jsonxx::Number>("streamingSvg"));
+    
+    if (json.has<jsonxx::Number>("progressiveLayout"))
+        SetProgressiveLayout(json.get<jsonxx::Number>("progressiveLayout"));
+    
+    if (json.has<jsonxx::Number>("threads"))
+        SetThreads(json.get<jsonxx::Number>("threads"));
+    
+    if (json.has<jsonxx::Number>("uuidSeed"))
+        SetUuidSeed(json.get<jsonxx::Number>("uuidSeed"));
+    
     return true;
     
 #else
@@ -439,8 +581,7 @@ std::string Toolkit::GetElementAttr( const std::string &xmlId )
 #ifdef USE_EMSCRIPTEN
     jsonxx::Object o;
     
-    if ( !m_doc.GetDrawingPage() ) return o.json();
-    Object *element = m_doc.GetDrawingPage()->FindChildByUuid(xmlId);
+    Object *element = FindDrawingPageElement(xmlId);
     if (!element) {
         LogMessage("Element with id '%s' could not be found", xmlId.c_str() );
         return o.json();
@@ -537,6 +678,15 @@ void  Toolkit::ResetLogBuffer() {
 
 std::string Toolkit::RenderToSvg( int pageNo, bool xml_declaration )
 {
+    // Cast off the pages up to this one if this was not done yet
+    this->ContinueLayout( std::max( pageNo, 1 ) );
+    
+    // The page count is exact only now that the page is cast off
+    if ( ( pageNo < 1 ) || ( pageNo > m_doc.GetPageCount() ) ) {
+        LogError( "The page requested (%d) is not in the page range (max is %d)", pageNo, m_doc.GetPageCount() );
+        return "";
+    }
+    
     // Page number is one-based - correction to 0-based first
     pageNo--;
     
@@ -554,21 +704,35 @@ std::string Toolkit::RenderToSvg( int pageNo, bool xml_declaration )
         height = m_doc.GetAdjustedDrawingPageHeight();
     }
     
+    // Write the SVG as text as the page is drawn
+    if ( m_streamingSvg ) {
+        StreamingSvgDeviceContext svg( width, height );
+        DrawCurrentPage( &svg );
+        return svg.GetStringSVG( xml_declaration );
+    }
+    
     // Create the SVG object, h & w come from the system
     // We will need to set the size of the page after having drawn it depending on the options
     SvgDeviceContext svg( width, height );
+    DrawCurrentPage( &svg );
     
+    std::string out_str = svg.GetStringSVG( xml_declaration );
+    return out_str;
+}
+    
+void Toolkit::DrawCurrentPage( DeviceContext *dc )
+{
     // set scale and border from user options
-    svg.SetUserScale((double)m_scale / 100, (double)m_scale / 100);
+    dc->SetUserScale((double)m_scale / 100, (double)m_scale / 100);
     
     // debug BB?
-    svg.SetDrawBoundingBoxes(m_showBoundingBoxes);
+    dc->SetDrawBoundingBoxes(m_showBoundingBoxes);
     
-    // render the page
-    m_view.DrawCurrentPage( &svg, false );
+    // the glyphs are needed by the device context
+    dc->SetResources( m_doc.GetResources() );
     
-    std::string out_str = svg.GetStringSVG( xml_declaration );
-    return out_str;
+    // render the page
+    m_view.DrawCurrentPage( dc, false );
 }
 
 void Toolkit::RedoLayout()
@@ -582,12 +746,121 @@ void Toolkit::RedoLayout()
     m_doc.SetSpacingSystem( this->GetSpacingSystem() );
     
     m_doc.UnCastOff();
-    m_doc.CastOff();
+    m_doc.CastOff( m_progressiveLayout );
+}
+
+void Toolkit::ContinueLayout( int pageNo )
+{
+    // nothing to do if the page is there and is not the last one (which will be cast off again)
+    if ( m_doc.IsCastOffComplete() || ( ( pageNo > 0 ) && ( pageNo < m_doc.GetPageCount() ) ) ) {
+        return;
+    }
+    
+    // Page number is one-based - 0 (i.e., -1 for the doc) continues until the end
+    m_doc.ContinueCastOff( pageNo - 1 );
+}
+
+bool Toolkit::GetSystemBreaks( const std::vector<int> &pageWidths, std::vector<std::vector<int> > *breaks )
+{
+    assert( breaks );
+    breaks->clear();
+    
+    std::vector<int>::const_iterator iter;
+    for (iter = pageWidths.begin(); iter != pageWidths.end(); iter++) {
+        if ( (*iter < MIN_PAGE_WIDTH) || (*iter > MAX_PAGE_WIDTH) ) {
+            LogError( "Page width out of bounds; default is %d, minimun is %d, and maximum is %d", DEFAULT_PAGE_WIDTH, MIN_PAGE_WIDTH, MAX_PAGE_WIDTH );
+            return false;
+        }
+    }
+    
+    // One single system whatever the page width
+    if ( m_noLayout ) {
+        breaks->resize( pageWidths.size() );
+        return true;
+    }
+    
+    if ( !PrepareSystemBreaks() ) {
+        return false;
+    }
+    
+    // The widths are processed in increasing order, so the breaks of one width are reused for the following
+    // ones until the width at which they change
+    std::vector<int> sortedWidths = pageWidths;
+    std::sort( sortedWidths.begin(), sortedWidths.end() );
+    std::map<int, std::vector<int> > widthBreaks;
+    std::vector<int> currentBreaks;
+    int nextWidth = VRV_UNSET;
+    for (iter = sortedWidths.begin(); iter != sortedWidths.end(); iter++) {
+        if ( (iter == sortedWidths.begin()) || ( (nextWidth != VRV_UNSET) && (*iter >= nextWidth) ) ) {
+            nextWidth = m_doc.GetCastOffSystemBreaks( *iter, &currentBreaks );
+        }
+        widthBreaks[*iter] = currentBreaks;
+    }
+    
+    for (iter = pageWidths.begin(); iter != pageWidths.end(); iter++) {
+        breaks->push_back( widthBreaks[*iter] );
+    }
+    return true;
+}
+    
+std::vector<int> Toolkit::GetSystemBreakWidths( int minWidth, int maxWidth )
+{
+    std::vector<int> widths;
+    
+    if ( (minWidth < MIN_PAGE_WIDTH) || (maxWidth > MAX_PAGE_WIDTH) || (minWidth > maxWidth) ) {
+        LogError( "Page widths out of bounds; minimun is %d, and maximum is %d", MIN_PAGE_WIDTH, MAX_PAGE_WIDTH );
+        return widths;
+    }
+    
+    widths.push_back( minWidth );
+    
+    // One single system whatever the page width
+    if ( m_noLayout ) {
+        return widths;
+    }
+    
+    if ( !PrepareSystemBreaks() ) {
+        widths.clear();
+        return widths;
+    }
+    
+    std::vector<int> breaks;
+    int width = m_doc.GetCastOffSystemBreaks( minWidth, &breaks );
+    while ( (width != VRV_UNSET) && (width <= maxWidth) ) {
+        widths.push_back( width );
+        width = m_doc.GetCastOffSystemBreaks( width, &breaks );
+    }
+    return widths;
+}
+    
+bool Toolkit::PrepareSystemBreaks( )
+{
+    if ( m_doc.GetPageCount() == 0 ) {
+        LogError( "No data loaded" );
+        return false;
+    }
+    
+    // the layout is kept only once all the pages have been cast off
+    this->ContinueLayout();
+    
+    if ( !m_doc.HasCastOffLayout() ) {
+        this->RedoLayout();
+        this->ContinueLayout();
+    }
+    
+    if ( !m_doc.HasCastOffLayout() ) {
+        LogWarning( "The system breaks cannot be computed without laying out the document for each page width" );
+        return false;
+    }
+    return true;
 }
 
 bool Toolkit::RenderToSvgFile( const std::string &filename, int pageNo )
 {
     std::string output = RenderToSvg( pageNo, true );
+    if ( output.empty() ) {
+        return false;
+    }
     
     std::ofstream outfile;
     outfile.open ( filename.c_str() );
@@ -604,12 +877,18 @@ bool Toolkit::RenderToSvgFile( const std::string &filename, int pageNo )
 
 
 int Toolkit::GetPageCount() {
-    return m_doc.GetPageCount();
+    // estimated as long as the pages are cast off progressively
+    return m_doc.GetEstimatedPageCount();
 }
 
 int Toolkit::GetPageWithElement( const std::string &xmlId )
 {
-    Object *element = m_doc.FindChildByUuid(xmlId);
+    Object *element = m_doc.FindObjectByUuid(xmlId);
+    // the element might be in the content not cast off yet, which is in the index but not on a page
+    if ((!element || !element->GetFirstParent( PAGE )) && !m_doc.IsCastOffComplete()) {
+        this->ContinueLayout();
+        element = m_doc.FindObjectByUuid(xmlId);
+    }
     if (!element) {
         return 0;
     }
@@ -620,6 +899,19 @@ int Toolkit::GetPageWithElement( const std::string &xmlId )
     return page->GetIdx() + 1;
 }
 
+Object *Toolkit::FindDrawingPageElement( const std::string &xmlId )
+{
+    Page *page = m_doc.GetDrawingPage();
+    if ( !page ) {
+        return NULL;
+    }
+    Object *element = m_doc.FindObjectByUuid( xmlId );
+    if ( !element || ( ( element != page ) && ( element->GetFirstParent( PAGE ) != page ) ) ) {
+        return NULL;
+    }
+    return element;
+}
+
 void Toolkit::SetCString( const std::string &data )
 {
     if (m_cString) {
@@ -648,8 +940,8 @@ const char *Toolkit::GetCString( )
     
 bool Toolkit::Drag( std::string elementId, int x, int y )
 {
-    if ( !m_doc.GetDrawingPage() ) return false;
-    Object *element = m_doc.GetDrawingPage()->FindChildByUuid(elementId);
+    Object *element = FindDrawingPageElement(elementId);
+    if ( !element ) return false;
     if ( element->Is() == NOTE ) {
         Note *note = dynamic_cast<Note*>(element);
         assert( note );
@@ -659,6 +951,7 @@ bool Toolkit::Drag( std::string elementId, int x, int y )
         data_PITCHNAME pname = (data_PITCHNAME)m_view.CalculatePitchCode( layer, m_view.ToLogicalY(y), note->GetDrawingX(), &oct  );
         note->SetPname(pname);
         note->SetOct(oct);
+        this->LayOutModified( note );
         return true;
     }
     return false;
@@ -668,8 +961,8 @@ bool Toolkit::Insert( std::string elementType, std::string startid, std::string
 {
     LogMessage("Insert!");
     if ( !m_doc.GetDrawingPage() ) return false;
-    Object *start = m_doc.GetDrawingPage()->FindChildByUuid(startid);
-    Object *end = m_doc.GetDrawingPage()->FindChildByUuid(endid);
+    Object *start = FindDrawingPageElement(startid);
+    Object *end = FindDrawingPageElement(endid);
     // Check if both start and end elements exist
     if ( !start || !end ) {
         LogMessage("Elements start and end ids '%s' and '%s' could not be found", startid.c_str(), endid.c_str() );
@@ -688,25 +981,48 @@ bool Toolkit::Insert( std::string elementType, std::string startid, std::string
     Measure *measure = dynamic_cast<Measure*>(start->GetFirstParent( MEASURE ) );
     assert( measure );
     if (elementType == "slur" ) {
+        UuidGeneratorScope uuidScope( m_doc.GetUuidGenerator() );
         Slur *slur = new Slur();
         slur->SetStartid( startid );
         slur->SetEndid( endid );
         measure->AddFloatingElement(slur);
+        // the content not cast off yet would not be prepared
+        this->ContinueLayout();
         m_doc.PrepareDrawing();
+        this->LayOutModified( measure );
         return true;
     }
     return false;
 }
 
+void Toolkit::LayOutModified( Object *element )
+{
+    Page *page = m_doc.GetDrawingPage();
+    if ( !page ) return;
+    
+    Object *measure = ( element->Is() == MEASURE ) ? element : element->GetFirstParent( MEASURE );
+    if ( measure ) {
+        measure->Modify();
+    }
+    else {
+        page->Modify();
+    }
+    
+    if ( page->LayOutModified() ) {
+        this->RedoLayout();
+    }
+}
+
 bool Toolkit::Set( std::string elementId, std::string attrType, std::string attrValue )
 {
-    if ( !m_doc.GetDrawingPage() ) return false;
-    Object *element = m_doc.GetDrawingPage()->FindChildByUuid(elementId);
-    if ( Att::SetCmn(element, attrType, attrValue )) return true;
-    if ( Att::SetCritapp(element, attrType, attrValue )) return true;
-    if ( Att::SetMensural(element, attrType, attrValue )) return true;
-    if ( Att::SetPagebased(element, attrType, attrValue )) return true;
-    if ( Att::SetShared(element, attrType, attrValue )) return true;
+    Object *element = FindDrawingPageElement(elementId);
+    if ( !element ) return false;
+    if ( Att::SetCmn(element, attrType, attrValue ) || Att::SetCritapp(element, attrType, attrValue )
+        || Att::SetMensural(element, attrType, attrValue ) || Att::SetPagebased(element, attrType, attrValue )
+        || Att::SetShared(element, attrType, attrValue )) {
+        this->LayOutModified( element );
+        return true;
+    }
     return false;
 }
     
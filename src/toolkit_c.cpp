@@ -0,0 +1,285 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:        toolkit_c.cpp
+// Author:      Laurent Pugin
+// Created:     2015
+// Copyright (c) Authors and others. All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+
+
+#include "toolkit_c.h"
+
+//----------------------------------------------------------------------------
+
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <string>
+
+//----------------------------------------------------------------------------
+
+#include "toolkit.h"
+#include "vrv.h"
+
+using namespace vrv;
+
+//----------------------------------------------------------------------------
+// vrvToolkit
+//----------------------------------------------------------------------------
+
+/**
+ * The opaque handle of the C interface.
+ * The output is kept only when it did not fit in the buffer of the caller, so
+ * the next call with a larger buffer does not render the page again.
+ */
+struct vrvToolkit
+{
+    vrvToolkit() : m_toolkit( false ) { ClearOutput(); };
+
+    void ClearOutput()
+    {
+        m_output.clear();
+        m_outputType = "";
+        m_outputPage = -1;
+    };
+
+    Toolkit m_toolkit;
+    std::string m_output;
+    std::string m_outputType;
+    int m_outputPage;
+};
+
+/**
+ * Copy the output into the buffer, as snprintf does, and return its length.
+ */
+static long CopyOutput( const std::string &output, char *buffer, size_t size )
+{
+    if ( buffer && (size > 0) ) {
+        size_t length = ( output.size() < size ) ? output.size() : size - 1;
+        memcpy( buffer, output.data(), length );
+        buffer[length] = 0;
+    }
+    return (long)output.size();
+}
+
+/**
+ * Copy the output of the toolkit into the buffer and keep it if it was truncated.
+ */
+static long CopyToolkitOutput( vrvToolkit *tk, char *buffer, size_t size )
+{
+    long length = CopyOutput( tk->m_output, buffer, size );
+    if ( (size_t)length < size ) {
+        tk->ClearOutput();
+    }
+    return length;
+}
+
+/**
+ * Log the exception being handled, since no exception can go through the C interface.
+ * To be called from a catch block.
+ */
+static void LogException( const char *function )
+{
+    try {
+        throw;
+    }
+    catch ( const std::exception &e ) {
+        LogError( "%s failed: %s", function, e.what() );
+    }
+    catch ( ... ) {
+        LogError( "%s failed with an unknown exception", function );
+    }
+}
+
+static bool ParseFlag( const char *value )
+{
+    return ( (strcmp( value, "true" ) == 0) || (atoi( value ) != 0) );
+}
+
+//----------------------------------------------------------------------------
+// C functions
+//----------------------------------------------------------------------------
+
+extern "C" {
+
+vrvToolkit *vrvToolkit_create( const char *resourcePath )
+{
+    vrvToolkit *tk = NULL;
+    try {
+        tk = new vrvToolkit();
+        // The font files are loaded only once but each toolkit has its own path and font selection
+        if ( !tk->m_toolkit.SetResourcePath( resourcePath ? resourcePath : Resources::GetDefaultPath() ) ) {
+            delete tk;
+            return NULL;
+        }
+        return tk;
+    }
+    catch ( ... ) {
+        LogException( "vrvToolkit_create" );
+        delete tk;
+        return NULL;
+    }
+}
+
+void vrvToolkit_destroy( vrvToolkit *tk )
+{
+    delete tk;
+}
+
+int vrvToolkit_setOption( vrvToolkit *tk, const char *name, const char *value )
+{
+    if ( !tk || !name || !value ) return 0;
+
+    try {
+        tk->ClearOutput();
+
+        Toolkit &toolkit = tk->m_toolkit;
+        std::string option = name;
+        bool ok = true;
+
+        if ( option == "format" ) ok = toolkit.SetFormat( value );
+        else if ( option == "font" ) ok = toolkit.SetFont( value );
+        else if ( option == "border" ) ok = toolkit.SetBorder( atoi( value ) );
+        else if ( option == "scale" ) ok = toolkit.SetScale( atoi( value ) );
+        else if ( option == "pageHeight" ) ok = toolkit.SetPageHeight( atoi( value ) );
+        else if ( option == "pageWidth" ) ok = toolkit.SetPageWidth( atoi( value ) );
+        else if ( option == "spacingLinear" ) ok = toolkit.SetSpacingLinear( atof( value ) );
+        else if ( option == "spacingNonLinear" ) ok = toolkit.SetSpacingNonLinear( atof( value ) );
+        else if ( option == "spacingStaff" ) ok = toolkit.SetSpacingStaff( atoi( value ) );
+        else if ( option == "spacingSystem" ) ok = toolkit.SetSpacingSystem( atoi( value ) );
+        else if ( option == "threads" ) ok = toolkit.SetThreads( atoi( value ) );
+        else if ( option == "uuidSeed" ) ok = toolkit.SetUuidSeed( atoi( value ) );
+        else if ( option == "rdgXPathQuery" ) toolkit.SetRdgXPathQuery( value );
+        else if ( option == "adjustPageHeight" ) toolkit.SetAdjustPageHeight( ParseFlag( value ) );
+        else if ( option == "evenNoteSpacing" ) toolkit.SetEvenNoteSpacing( ParseFlag( value ) );
+        else if ( option == "ignoreLayout" ) toolkit.SetIgnoreLayout( ParseFlag( value ) );
+        else if ( option == "noLayout" ) toolkit.SetNoLayout( ParseFlag( value ) );
+        else if ( option == "noJustification" ) toolkit.SetNoJustification( ParseFlag( value ) );
+        else if ( option == "showBoundingBoxes" ) toolkit.SetShowBoundingBoxes( ParseFlag( value ) );
+        else if ( option == "streamingSvg" ) toolkit.SetStreamingSvg( ParseFlag( value ) );
+        else if ( option == "progressiveLayout" ) toolkit.SetProgressiveLayout( ParseFlag( value ) );
+        else {
+            LogError( "Unknown option '%s'", name );
+            ok = false;
+        }
+
+        return ok ? 1 : 0;
+    }
+    catch ( ... ) {
+        LogException( "vrvToolkit_setOption" );
+        return 0;
+    }
+}
+
+int vrvToolkit_loadFile( vrvToolkit *tk, const char *filename )
+{
+    if ( !tk || !filename ) return 0;
+
+    try {
+        tk->ClearOutput();
+        return tk->m_toolkit.LoadFile( filename ) ? 1 : 0;
+    }
+    catch ( ... ) {
+        LogException( "vrvToolkit_loadFile" );
+        return 0;
+    }
+}
+
+int vrvToolkit_loadData( vrvToolkit *tk, const char *data, size_t size )
+{
+    if ( !tk || (!data && (size > 0)) ) return 0;
+
+    try {
+        tk->ClearOutput();
+        return tk->m_toolkit.LoadString( std::string( data, size ) ) ? 1 : 0;
+    }
+    catch ( ... ) {
+        LogException( "vrvToolkit_loadData" );
+        return 0;
+    }
+}
+
+int vrvToolkit_getPageCount( vrvToolkit *tk )
+{
+    if ( !tk ) return 0;
+
+    try {
+        return tk->m_toolkit.GetPageCount();
+    }
+    catch ( ... ) {
+        LogException( "vrvToolkit_getPageCount" );
+        return 0;
+    }
+}
+
+void vrvToolkit_redoLayout( vrvToolkit *tk )
+{
+    if ( !tk ) return;
+
+    try {
+        tk->ClearOutput();
+        tk->m_toolkit.RedoLayout();
+    }
+    catch ( ... ) {
+        LogException( "vrvToolkit_redoLayout" );
+    }
+}
+
+long vrvToolkit_renderPage( vrvToolkit *tk, int pageNo, char *buffer, size_t size )
+{
+    if ( !tk || (pageNo < 1) ) return -1;
+
+    try {
+        // the page count is only an estimate until the pages are cast off
+        tk->m_toolkit.ContinueLayout( pageNo );
+        if ( pageNo > tk->m_toolkit.GetPageCount() ) return -1;
+
+        if ( (tk->m_outputType != "svg") || (tk->m_outputPage != pageNo) ) {
+            tk->m_output = tk->m_toolkit.RenderToSvg( pageNo );
+            tk->m_outputType = "svg";
+            tk->m_outputPage = pageNo;
+        }
+        return CopyToolkitOutput( tk, buffer, size );
+    }
+    catch ( ... ) {
+        LogException( "vrvToolkit_renderPage" );
+        tk->ClearOutput();
+        return -1;
+    }
+}
+
+long vrvToolkit_getMEI( vrvToolkit *tk, int pageNo, int scoreBased, char *buffer, size_t size )
+{
+    if ( !tk || (pageNo < 0) ) return -1;
+
+    try {
+        // all the pages are cast off for the whole document
+        tk->m_toolkit.ContinueLayout( pageNo );
+        if ( pageNo > tk->m_toolkit.GetPageCount() ) return -1;
+
+        std::string type = scoreBased ? "mei-score" : "mei";
+        if ( (tk->m_outputType != type) || (tk->m_outputPage != pageNo) ) {
+            tk->m_output = tk->m_toolkit.GetMEI( pageNo, scoreBased != 0 );
+            tk->m_outputType = type;
+            tk->m_outputPage = pageNo;
+        }
+        return CopyToolkitOutput( tk, buffer, size );
+    }
+    catch ( ... ) {
+        LogException( "vrvToolkit_getMEI" );
+        tk->ClearOutput();
+        return -1;
+    }
+}
+
+long vrvToolkit_getVersion( char *buffer, size_t size )
+{
+    try {
+        return CopyOutput( GetVersion(), buffer, size );
+    }
+    catch ( ... ) {
+        LogException( "vrvToolkit_getVersion" );
+        return -1;
+    }
+}
+
+} // extern "C"
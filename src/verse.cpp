@@ -15,6 +15,7 @@
 //----------------------------------------------------------------------------
 
 #include "aligner.h"
+#include "att_comparison.h"
 #include "editorial.h"
 #include "layer.h"
 #include "staff.h"
@@ -95,5 +96,44 @@ int Verse::PrepareProcessingLists( ArrayPtrVoid *params )
     
     return FUNCTOR_SIBLINGS;
 }
+    
+int Verse::PrepareByLayer( ArrayPtrVoid *params )
+{
+    // param 0: the MapOfPrepareLayerStates (unused)
+    // param 1: the current PrepareLayerState
+    // param 2: the current Staff (unused)
+    // param 3: the PrepareLyrics params of the current Verse
+    // param 4: the MapOfStaffUuidGenerators (unused)
+    PrepareLayerState **currentState = static_cast<PrepareLayerState**>((*params).at(1));
+    ArrayPtrVoid **currentLyricsParams = static_cast<ArrayPtrVoid**>((*params).at(3));
+    
+    // Only the first verse with a given @n is processed within the parent
+    AttCommonNComparison matchVerse( VERSE, this->GetN() );
+    if ( !(*currentState) || this->HasPreviousSiblingByAttComparison( &matchVerse ) ) {
+        return FUNCTOR_SIBLINGS;
+    }
+    
+    std::map<int, ArrayPtrVoid>::iterator iter = (*currentState)->m_lyricsParams.find( this->GetN() );
+    if ( iter == (*currentState)->m_lyricsParams.end() ) {
+        return FUNCTOR_SIBLINGS;
+    }
+    (*currentLyricsParams) = &iter->second;
+    
+    return FUNCTOR_CONTINUE;
+}
+    
+int Verse::PrepareByLayerEnd( ArrayPtrVoid *params )
+{
+    // param 0: the MapOfPrepareLayerStates (unused)
+    // param 1: the current PrepareLayerState (unused)
+    // param 2: the current Staff (unused)
+    // param 3: the PrepareLyrics params of the current Verse
+    // param 4: the MapOfStaffUuidGenerators (unused)
+    ArrayPtrVoid **currentLyricsParams = static_cast<ArrayPtrVoid**>((*params).at(3));
+    
+    (*currentLyricsParams) = NULL;
+    
+    return FUNCTOR_CONTINUE;
+}
   
 } // namespace vrv
@@ -21,7 +21,6 @@
 
 namespace vrv {
     
-int View::s_deCasteljau[4][4];
 
 //----------------------------------------------------------------------------
 // View
@@ -38,6 +37,10 @@ View::View( )
     m_currentMeasure = NULL;
 	m_currentStaff = NULL;
     m_currentSystem = NULL;
+    
+    m_drawingLigX[0] = m_drawingLigX[1] = 0;
+    m_drawingLigY[0] = m_drawingLigY[1] = 0;
+    m_drawingLigObliqua = false;
 }
 
 
@@ -196,19 +199,21 @@ Point View::CalcPositionAfterRotation( Point point , float rot_alpha, Point cent
 int View::CalcBezierAtPosition(Point bezier[], int x)
 {
     int i, j;
+    // buffer for De-Casteljau algorithm
+    int deCasteljau[4][4];
     double t = 0.0;
     // avoid division by 0
     if (bezier[3].x != bezier[0].x) t = (double)(x - bezier[0].x) / (double)(bezier[3].x - bezier[0].x) ;
     t = std::min(1.0, std::max(0.0, t));
     int n = 4;
     
-    for(i = 0; i < n; i++) View::s_deCasteljau[0][i] = bezier[i].y;
+    for(i = 0; i < n; i++) deCasteljau[0][i] = bezier[i].y;
     for(j = 1; j < n; j++) {
         for(int i = 0; i < 4 - j; i++) {
-            View::s_deCasteljau[j][i] = View::s_deCasteljau[j-1][i] * (1-t) + View::s_deCasteljau[j-1][i+1] * t;
+            deCasteljau[j][i] = deCasteljau[j-1][i] * (1-t) + deCasteljau[j-1][i+1] * t;
         }
     }
-    return View::s_deCasteljau[n-1][0];
+    return deCasteljau[n-1][0];
 }
     
 } // namespace vrv
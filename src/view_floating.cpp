@@ -455,7 +455,15 @@ float View::AdjustSlur(Slur *slur, Staff *staff, int layerN, bool up,  Point poi
     filters.push_back( &matchLayer );
     
     Functor timeSpanningLayerElements( &Object::TimeSpanningLayerElements );
-    system->Process( &timeSpanningLayerElements, &params, NULL, &filters );
+    // Skip the measures ending before the slur instead of processing the whole system from its start
+    // - the functor stops after the slur
+    ArrayOfObjects::iterator iter;
+    for (iter = system->m_children.begin(); iter != system->m_children.end(); ++iter) {
+        Measure *measure = dynamic_cast<Measure*>(*iter);
+        if ( measure && ( measure->GetDrawingX() + measure->GetRightBarlineX() < p1->x ) ) continue;
+        (*iter)->Process( &timeSpanningLayerElements, &params, NULL, &filters );
+        if ( timeSpanningLayerElements.m_returnCode == FUNCTOR_STOP ) break;
+    }
     //if (spanningContent.size() > 12) LogDebug("### %d %s", spanningContent.size(), slur->GetUuid().c_str());
     
     ArrayOfLayerElementPointPairs spanningContentPoints;
@@ -586,7 +594,7 @@ int View::AdjustSlurCurve(Slur *slur, ArrayOfLayerElementPointPairs *spanningPoi
     int maxHeight = 0;
     
     // 0.2 for avoiding / by 0 (below)
-    float maxHeightFactor = std::max(0.2, fabs(angle));
+    float maxHeightFactor = std::max(0.2f, fabs(angle));
     maxHeight = dist / (maxHeightFactor * (TEMP_STYLE_SLUR_CURVE_FACTOR + 5)); // 5 is the minimum - can be increased for limiting curvature
     if (posRatio) {
         // Do we want to set a max height?
@@ -26,9 +26,6 @@
 
 namespace vrv {    
 
-int View::s_drawingLigX[2], View::s_drawingLigY[2];	// pour garder coord. des ligatures
-bool View::s_drawingLigObliqua = false;	// marque le 1e passage pour une oblique
-
 //----------------------------------------------------------------------------
 // View - Mensural
 //----------------------------------------------------------------------------
@@ -438,7 +435,7 @@ void View::DrawLigature ( DeviceContext *dc, int y, LayerElement *element, Layer
     y4 = (int)(y2 - m_doc->GetDrawingUnit(staff->m_drawingStaffSize)/2);
     
     
-    //if (!note->m_ligObliqua && (!View::s_drawingLigObliqua))	// notes rectangulaires, y c. en ligature
+    //if (!note->m_ligObliqua && (!m_drawingLigObliqua))	// notes rectangulaires, y c. en ligature
     {
         if (note->GetColored()!=BOOLEAN_true)
         {				//	double base des carrees
@@ -454,10 +451,10 @@ void View::DrawLigature ( DeviceContext *dc, int y, LayerElement *element, Layer
     /*
      else			// traitement des obliques
      {
-     if (!View::s_drawingLigObliqua)	// 1e passage: ligne flagStemHeighte initiale
+     if (!m_drawingLigObliqua)	// 1e passage: ligne flagStemHeighte initiale
      {
      DrawVerticalLine (dc,y3,y4,x1, m_doc->GetDrawingStemWidth(staff->m_drawingStaffSize) );
-     View::s_drawingLigObliqua = true;
+     m_drawingLigObliqua = true;
      //oblique = OFF;
      //			if (val == DUR_1)	// queue gauche haut si DUR_1
      //				queue_lig = ON;
@@ -466,7 +463,7 @@ void View::DrawLigature ( DeviceContext *dc, int y, LayerElement *element, Layer
      {
      x1 -=  m_doc->m_drawingBrevisWidth[staff->m_drawingStaffSize]*2;	// avance auto
      
-     y1 = *View::s_drawingLigY - m_doc->GetDrawingUnit(staff->m_drawingStaffSize);	// ligat_y contient y original
+     y1 = *m_drawingLigY - m_doc->GetDrawingUnit(staff->m_drawingStaffSize);	// ligat_y contient y original
      yy2 = y2;
      y5 = y1+ m_doc->GetDrawingDoubleUnit(staff->m_drawingStaffSize); y2 += m_doc->GetDrawingDoubleUnit(staff->m_drawingStaffSize);	// on monte d'un INTERL
      
@@ -478,7 +475,7 @@ void View::DrawLigature ( DeviceContext *dc, int y, LayerElement *element, Layer
      }
      DrawVerticalLine ( dc,y3,y4,x2,m_doc->GetDrawingStemWidth(staff->m_drawingStaffSize));	//cloture flagStemHeighte
      
-     View::s_drawingLigObliqua = false;
+     m_drawingLigObliqua = false;
      //			queue_lig = OFF;	//desamorce alg.queue DUR_BR
      
      }
@@ -486,12 +483,12 @@ void View::DrawLigature ( DeviceContext *dc, int y, LayerElement *element, Layer
      
      if (note->m_lig)	// memoriser positions d'une note a l'autre; relier notes par barres
      {
-     *(View::s_drawingLigX+1) = x2; *(View::s_drawingLigY+1) = y;	// relie notes ligaturees par barres flagStemHeightes
-     //if (in(x1,(*View::s_drawingLigX)-2,(*View::s_drawingLigX)+2) || (this->fligat && this->lat && !Note1::marq_obl))
+     *(m_drawingLigX+1) = x2; *(m_drawingLigY+1) = y;	// relie notes ligaturees par barres flagStemHeightes
+     //if (in(x1,(*m_drawingLigX)-2,(*m_drawingLigX)+2) || (this->fligat && this->lat && !Note1::marq_obl))
      // les dernieres conditions pour permettre ligature flagStemHeighte ancienne
      //	DrawVerticalLine (dc, *ligat_y, y1, (this->fligat && this->lat) ? x2: x1, m_doc->m_parameters.m_stemWidth); // ax2 - drawing flagStemHeight lines missing
-     *View::s_drawingLigX = *(View::s_drawingLigX + 1);
-     *View::s_drawingLigY = *(View::s_drawingLigY + 1);
+     *m_drawingLigX = *(m_drawingLigX + 1);
+     *m_drawingLigY = *(m_drawingLigY + 1);
      }
      
      
@@ -46,6 +46,9 @@ void View::DrawCurrentPage( DeviceContext *dc, bool background )
 	assert( dc );
     assert( m_doc );
     
+    // the glyphs are the ones of the fonts of the document
+    dc->SetResources( m_doc->GetResources() );
+    
     m_currentPage = m_doc->SetDrawingPage( m_pageIdx );
     
     int i;
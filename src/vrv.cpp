@@ -9,10 +9,15 @@
 
 //----------------------------------------------------------------------------
 
+#include <algorithm>
 #include <assert.h>
 #include <dirent.h>
 #include <cmath>
+#include <fstream>
+#include <pthread.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <sys/stat.h>
 
 //----------------------------------------------------------------------------
 
@@ -25,36 +30,103 @@
 //----------------------------------------------------------------------------
 
 #define STRING_FORMAT_MAX_LEN 2048
+    
+/**
+ * Magic string and version at the beginning of a compiled font bundle.
+ * The version has to be increased when the binary layout changes.
+ */
+#define FONT_BUNDLE_MAGIC "VRVFONT"
+#define FONT_BUNDLE_VERSION 2
 
 namespace vrv {
    
+//----------------------------------------------------------------------------
+// TextFont
+//----------------------------------------------------------------------------
+    
+/**
+ * The text font of a resource path, with the bounding boxes of its glyphs and
+ * the woff font included in the SVG when text is used.
+ */
+struct TextFont
+{
+    std::map<wchar_t, Glyph> m_glyphs;
+    pugi::xml_document m_definition;
+};
+   
 //----------------------------------------------------------------------------
 // Static members with some default values
 //----------------------------------------------------------------------------
     
-std::string Resources::m_path = "/usr/local/share/verovio";
-std::map<wchar_t, Glyph> Resources::m_font;
-std::map<wchar_t, Glyph> Resources::m_textFont;
+std::string Resources::m_defaultPath = "/usr/local/share/verovio";
+std::map<std::string, std::map<wchar_t, Glyph> > Resources::m_loadedFonts;
+std::map<std::string, pugi::xml_document*> Resources::m_loadedFontDefinitions;
+std::map<std::string, MapOfCodeGlyphs> Resources::m_fontSets;
+std::map<std::string, TextFont*> Resources::m_textFonts;
+    
+/**
+ * The mutex for loading the fonts and changing the default resource path.
+ * Glyphs are read without locking since loaded fonts are never modified.
+ */
+static pthread_mutex_t resourcesMutex = PTHREAD_MUTEX_INITIALIZER;
+    
+/**
+ * Lock the resourcesMutex for the scope of the variable.
+ */
+class ResourcesLock
+{
+public:
+    ResourcesLock() { pthread_mutex_lock( &resourcesMutex ); };
+    ~ResourcesLock() { pthread_mutex_unlock( &resourcesMutex ); };
+};
   
 //----------------------------------------------------------------------------
 // Font related methods
 //----------------------------------------------------------------------------
     
+Resources::Resources()
+{
+    m_path = Resources::GetDefaultPath();
+    m_font = NULL;
+    m_textFont = NULL;
+}
+    
+std::string Resources::GetDefaultPath()
+{
+    ResourcesLock lock;
+    return m_defaultPath;
+}
+    
+void Resources::SetDefaultPath(std::string path)
+{
+    ResourcesLock lock;
+    m_defaultPath = path;
+}
+    
 bool Resources::InitFonts()
 {
+    ResourcesLock lock;
+    
     // We will need to rethink this for adding the option to add custom fonts
     // Font Bravura first since it is expected to have always all symbols
-    if (!LoadFont("Bravura")) LogError("Bravura font could not be loaded.");
+    if (!LoadFont(m_path, "Bravura")) LogError("Bravura font could not be loaded.");
     // The Leipzig as the default font
-    if (!LoadFont("Leipzig")) LogError("Leipzig font could not be loaded.");
+    if (!LoadFont(m_path, "Leipzig")) LogError("Leipzig font could not be loaded.");
+    
+    std::vector<std::string> fontNames;
+    fontNames.push_back("Bravura");
+    fontNames.push_back("Leipzig");
+    m_fontNames = fontNames;
+    m_font = GetFontSet(m_path, fontNames);
     
-    if ( m_font.size() < SMUFL_COUNT ) {
+    if ( m_font->size() < SMUFL_COUNT ) {
         LogError("Expected %d default SMUFL glyphs but could load only %d.",
-                 SMUFL_COUNT, m_font.size());
+                 SMUFL_COUNT, m_font->size());
         return false;
     }
     
-    if ( !InitTextFont() ) {
+    m_textFont = LoadTextFont(m_path);
+    if ( !m_textFont ) {
         LogError("Text font could not be initialized.");
         return false;
     }
@@ -64,26 +136,244 @@ bool Resources::InitFonts()
     
 bool Resources::SetFont(std::string fontName)
 {
-    return LoadFont(fontName);
+    ResourcesLock lock;
+    
+    if (!LoadFont(m_path, fontName)) return false;
+    
+    // The font is used on top of the current ones - a font selected previously is moved to the top
+    std::vector<std::string> fontNames;
+    std::vector<std::string>::iterator iter;
+    for (iter = m_fontNames.begin(); iter != m_fontNames.end(); ++iter) {
+        if ( *iter != fontName ) fontNames.push_back( *iter );
+    }
+    fontNames.push_back( fontName );
+    m_fontNames = fontNames;
+    m_font = GetFontSet(m_path, fontNames);
+    
+    return true;
 }
 
-Glyph *Resources::GetGlyph(wchar_t smuflCode)
+Glyph *Resources::GetGlyph(wchar_t smuflCode) const
 {
-    if (!m_font.count(smuflCode)) return NULL;
-    return &m_font[smuflCode];
+    if (!m_font) return NULL;
+    MapOfCodeGlyphs::const_iterator iter = m_font->find(smuflCode);
+    if (iter == m_font->end()) return NULL;
+    return iter->second;
 }
 
-Glyph *Resources::GetTextGlyph(wchar_t code)
+Glyph *Resources::GetTextGlyph(wchar_t code) const
+{
+    if (!m_textFont) return NULL;
+    std::map<wchar_t, Glyph>::const_iterator iter = m_textFont->m_glyphs.find(code);
+    if (iter == m_textFont->m_glyphs.end()) return NULL;
+    // The glyphs are never modified once loaded
+    return const_cast<Glyph*>( &iter->second );
+}
+    
+pugi::xml_node Resources::GetTextFontDefinition() const
 {
-    if (!m_textFont.count(code)) return NULL;
-    return &m_textFont[code];
+    if (!m_textFont) return pugi::xml_node();
+    return m_textFont->m_definition.first_child();
 }
     
-bool Resources::LoadFont(std::string fontName)
+bool Resources::LoadFont(const std::string &path, const std::string &fontName)
+{
+    std::string key = path + "/" + fontName;
+    if ( m_loadedFonts.count(key) ) return true;
+    
+    // Glyphs are loaded in a separate map so a font that cannot be loaded is not added
+    std::map<wchar_t, Glyph> font;
+    // Use the compiled font bundle if it is available and only then parse the XML files
+    if ( !LoadFontBundle(path, fontName, &font) && !LoadFontXML(path, fontName, &font) ) return false;
+    
+    // Parse the definitions once and keep them since they are copied to every SVG
+    pugi::xml_document *definitions = new pugi::xml_document();
+    std::map<wchar_t, Glyph>::iterator iter;
+    for (iter = font.begin(); iter != font.end(); ++iter) {
+        if ( iter->second.HasXML() ) {
+            const std::string &xml = iter->second.GetXML();
+            if ( definitions->append_buffer( xml.data(), xml.size() ) ) {
+                iter->second.SetDefinition( definitions->last_child() );
+            }
+        }
+    }
+    
+    m_loadedFonts[key] = font;
+    m_loadedFontDefinitions[key] = definitions;
+    return true;
+}
+    
+const MapOfCodeGlyphs *Resources::GetFontSet(const std::string &path, const std::vector<std::string> &fontNames)
+{
+    std::string key = path;
+    std::vector<std::string>::const_iterator iter;
+    for (iter = fontNames.begin(); iter != fontNames.end(); ++iter) {
+        key += ":" + (*iter);
+    }
+    
+    // Each combination of fonts is built only once and never modified since glyphs can be in use
+    std::map<std::string, MapOfCodeGlyphs>::iterator fontSetIter = m_fontSets.find(key);
+    if ( fontSetIter != m_fontSets.end() ) return &fontSetIter->second;
+    
+    MapOfCodeGlyphs *fontSet = &m_fontSets[key];
+    for (iter = fontNames.begin(); iter != fontNames.end(); ++iter) {
+        std::string fontKey = path + "/" + (*iter);
+        if ( !m_loadedFonts.count(fontKey) ) continue;
+        std::map<wchar_t, Glyph> *font = &m_loadedFonts[fontKey];
+        std::map<wchar_t, Glyph>::iterator glyphIter;
+        for (glyphIter = font->begin(); glyphIter != font->end(); ++glyphIter) {
+            (*fontSet)[glyphIter->first] = &glyphIter->second;
+        }
+    }
+    return fontSet;
+}
+    
+bool Resources::CreateFontBundle(std::string path, std::string fontName, std::string filename)
+{
+    std::map<wchar_t, Glyph> font;
+    if ( !LoadFontXML(path, fontName, &font) ) return false;
+    int fileCount;
+    long long lastModified;
+    if ( !GetFontXMLStamp(path, fontName, &fileCount, &lastModified) ) return false;
+    
+    // The bundle is made of:
+    // - the magic string (with its \0) and the version
+    // - the number of XML files and their last modification time
+    // - the number of glyphs
+    // - for each glyph, its code followed by the Glyph::WriteBundle data
+    // Values are written as native ints since the bundle is generated at build time
+    std::string buffer( FONT_BUNDLE_MAGIC, sizeof(FONT_BUNDLE_MAGIC) );
+    int value = FONT_BUNDLE_VERSION;
+    buffer.append( (const char *)&value, sizeof(int) );
+    buffer.append( (const char *)&fileCount, sizeof(int) );
+    buffer.append( (const char *)&lastModified, sizeof(long long) );
+    value = (int)font.size();
+    buffer.append( (const char *)&value, sizeof(int) );
+    
+    std::map<wchar_t, Glyph>::iterator iter;
+    for (iter = font.begin(); iter != font.end(); ++iter) {
+        value = (int)iter->first;
+        buffer.append( (const char *)&value, sizeof(int) );
+        if ( !iter->second.WriteBundle( &buffer ) ) return false;
+    }
+    
+    std::ofstream outfile( filename.c_str(), std::ios::binary );
+    if ( !outfile.is_open() ) {
+        LogError("Font bundle '%s' cannot be written", filename.c_str());
+        return false;
+    }
+    outfile.write( buffer.data(), buffer.size() );
+    outfile.close();
+    return true;
+}
+    
+bool Resources::LoadFontBundle(const std::string &path, const std::string &fontName, std::map<wchar_t, Glyph> *font)
+{
+    std::string filename = path + "/" + fontName + ".vrvfont";
+    std::ifstream in( filename.c_str(), std::ios::binary );
+    if ( !in.is_open() ) {
+        // No bundle, the XML files will be used
+        return false;
+    }
+    
+    // Read the whole bundle at once
+    in.seekg(0, std::ios::end);
+    std::streamsize fileSize = (std::streamsize)in.tellg();
+    in.seekg(0, std::ios::beg);
+    std::string content( fileSize, 0 );
+    in.read( &content[0], fileSize );
+    
+    const char *data = content.data();
+    const char *end = data + content.size();
+    int version, fileCount, count, code;
+    long long lastModified;
+    if ( (content.size() < sizeof(FONT_BUNDLE_MAGIC) + sizeof(int))
+        || (memcmp( data, FONT_BUNDLE_MAGIC, sizeof(FONT_BUNDLE_MAGIC) ) != 0) ) {
+        LogWarning("Font bundle '%s' is not valid", filename.c_str());
+        return false;
+    }
+    data += sizeof(FONT_BUNDLE_MAGIC);
+    memcpy( &version, data, sizeof(int) );
+    data += sizeof(int);
+    if ( version != FONT_BUNDLE_VERSION ) {
+        LogWarning("Font bundle '%s' has version %d (expected %d)", filename.c_str(), version, FONT_BUNDLE_VERSION);
+        return false;
+    }
+    if ( end - data < (int)(3 * sizeof(int) + sizeof(long long)) ) {
+        LogWarning("Font bundle '%s' is not valid", filename.c_str());
+        return false;
+    }
+    memcpy( &fileCount, data, sizeof(int) );
+    data += sizeof(int);
+    memcpy( &lastModified, data, sizeof(long long) );
+    data += sizeof(long long);
+    memcpy( &count, data, sizeof(int) );
+    data += sizeof(int);
+    
+    // The XML files are used if they were changed since the bundle was created
+    int xmlFileCount;
+    long long xmlLastModified;
+    if ( !GetFontXMLStamp(path, fontName, &xmlFileCount, &xmlLastModified) ) return false;
+    if ( (xmlFileCount != fileCount) || (xmlLastModified != lastModified) ) {
+        LogWarning("Font bundle '%s' is out of date, the XML files are used", filename.c_str());
+        return false;
+    }
+    
+    int i;
+    for (i = 0; i < count; i++) {
+        if ( end - data < (int)sizeof(int) ) break;
+        memcpy( &code, data, sizeof(int) );
+        data += sizeof(int);
+        if ( !(*font)[(wchar_t)code].ReadBundle( &data, end ) ) break;
+    }
+    if ( i != count ) {
+        LogWarning("Font bundle '%s' is truncated", filename.c_str());
+        font->clear();
+        return false;
+    }
+    
+    return true;
+}
+    
+bool Resources::GetFontXMLStamp(const std::string &path, const std::string &fontName, int *fileCount, long long *lastModified)
+{
+    DIR*    dir;
+    dirent* pdir;
+    std::string dirname =  path + "/" + fontName;
+    dir = opendir(dirname.c_str());
+    
+    if (!dir) {
+        LogError("Font directory '%s' cannot be read", dirname.c_str());
+        return false;
+    }
+    
+    // Only the files are looked at - this is much faster than parsing them
+    std::vector<std::string> filenames;
+    while ((pdir = readdir(dir))) {
+        if ( strstr( pdir->d_name, ".xml" )) {
+            filenames.push_back( dirname + "/" + pdir->d_name );
+        }
+    }
+    closedir(dir);
+    filenames.push_back( path + "/" + fontName + ".xml" );
+    
+    (*fileCount) = 0;
+    (*lastModified) = 0;
+    struct stat fileStat;
+    std::vector<std::string>::iterator iter;
+    for (iter = filenames.begin(); iter != filenames.end(); ++iter) {
+        if ( stat( iter->c_str(), &fileStat ) != 0 ) continue;
+        (*fileCount)++;
+        (*lastModified) = std::max( (*lastModified), (long long)fileStat.st_mtime );
+    }
+    return true;
+}
+    
+bool Resources::LoadFontXML(const std::string &path, const std::string &fontName, std::map<wchar_t, Glyph> *font)
 {
     DIR*    dir;
     dirent* pdir;
-    std::string dirname =  Resources::GetPath() + "/" + fontName;
+    std::string dirname =  path + "/" + fontName;
     dir = opendir(dirname.c_str());
     
     if (!dir) {
@@ -104,8 +394,8 @@ bool Resources::LoadFont(std::string fontName)
             }
             std::string codeStr = pdir->d_name;
             codeStr = codeStr.substr(0, 4);
-            Glyph glyph( Resources::GetPath() + "/" + fontName + "/" + pdir->d_name , codeStr );
-            m_font[smuflCode] = glyph;
+            Glyph glyph( path + "/" + fontName + "/" + pdir->d_name , codeStr );
+            (*font)[smuflCode] = glyph;
         }
     }
     
@@ -114,7 +404,7 @@ bool Resources::LoadFont(std::string fontName)
     
     // Then load the bounding boxes (if bounding box file is provided)
     pugi::xml_document doc;
-    std::string filename = Resources::GetPath() + "/" + fontName + ".xml";
+    std::string filename = path + "/" + fontName + ".xml";
     pugi::xml_parse_result result = doc.load_file( filename.c_str() );
     if (!result)
     {
@@ -132,11 +422,11 @@ bool Resources::LoadFont(std::string fontName)
     for( current = root.child("glyph"); current; current = current.next_sibling("glyph") ) {
         if ( current.attribute( "glyph-code" ) ) {
             wchar_t smuflCode = (wchar_t)strtol( current.attribute( "glyph-code" ).value(), NULL, 16);
-            if (!m_font.count(smuflCode)) {
+            if (!font->count(smuflCode)) {
                 LogWarning("Glyph with code '%d' not found.", smuflCode);
                 continue;
             }
-            Glyph *glyph = &m_font[smuflCode];
+            Glyph *glyph = &(*font)[smuflCode];
             if (glyph->GetUnitsPerEm() != unitsPerEm * 10) {
                 LogWarning("Glyph and bounding box units-per-em for code '%d' miss-match (bounding box: %d)", smuflCode, unitsPerEm);
                 continue;
@@ -155,26 +445,31 @@ bool Resources::LoadFont(std::string fontName)
 }
 
     
-bool Resources::InitTextFont()
+const TextFont *Resources::LoadTextFont(const std::string &path)
 {
+    // Already loaded from this resource path
+    std::map<std::string, TextFont*>::iterator textFontIter = m_textFonts.find( path );
+    if ( textFontIter != m_textFonts.end() ) return textFontIter->second;
+    
     // For the text font, we load the bounding boxes only
     pugi::xml_document doc;
     // For now, we have only Georgia.xml bounding boxes for ASCII chars
     // For any other char, we currently use 'o' bounding box
-    std::string filename = Resources::GetPath() + "/text/Georgia.xml";
+    std::string filename = path + "/text/Georgia.xml";
     pugi::xml_parse_result result = doc.load_file( filename.c_str() );
     if (!result)
     {
         // File not found, default bounding boxes will be used
         LogMessage("Cannot load bounding boxes for text font '%s'", filename.c_str());
-        return false;
+        return NULL;
     }
     pugi::xml_node root = doc.first_child();
     if (!root.attribute("units-per-em")) {
         LogWarning("No units-per-em attribute in bouding box file");
-        return false;
+        return NULL;
     }
     int unitsPerEm = atoi(root.attribute("units-per-em").value());
+    TextFont *textFont = new TextFont();
     pugi::xml_node current;
     for( current = root.child("glyph"); current; current = current.next_sibling("glyph") ) {
         if ( current.attribute( "glyph-code" ) ) {
@@ -189,10 +484,17 @@ bool Resources::InitTextFont()
             if ( current.attribute( "width" ) ) width = atof( current.attribute( "width" ).value() );
             if ( current.attribute( "height" ) ) height = atof( current.attribute( "height" ).value() );
             glyph.SetBoundingBox(x, y, width, height);
-            m_textFont[code] = glyph;
+            textFont->m_glyphs[code] = glyph;
         }
-    }                  
-    return true;
+    }
+    
+    // Also keep the woff VerovioText font that is included in the SVG when text is used
+    std::string woff = path + "/woff.xml";
+    if ( !textFont->m_definition.load_file( woff.c_str() ) ) {
+        LogWarning("Cannot load the woff text font '%s'", woff.c_str());
+    }
+    m_textFonts[path] = textFont;
+    return textFont;
 }
 
  
@@ -238,9 +540,12 @@ void LogDebug(const char *fmt, ...)
 #else
     va_list args;
     va_start ( args, fmt );
+    // lock stdout for the lines from several threads not to be mixed
+    flockfile(stdout);
     printf("[Debug] ");
     vprintf( fmt, args );
     printf("\n");
+    funlockfile(stdout);
     va_end ( args );
 #endif
 #endif
@@ -259,9 +564,11 @@ void LogError(const char *fmt, ...)
 #else
     va_list args;
     va_start ( args, fmt );
+    flockfile(stdout);
     printf("[Error] ");
     vprintf( fmt, args );
     printf("\n");
+    funlockfile(stdout);
     va_end ( args );
 #endif
 }
@@ -279,9 +586,11 @@ void LogMessage(const char *fmt, ...)
 #else
     va_list args;
     va_start ( args, fmt );
+    flockfile(stdout);
     printf("[Message] ");
     vprintf( fmt, args );
     printf("\n");
+    funlockfile(stdout);
     va_end ( args );
 #endif
 }
@@ -299,9 +608,11 @@ void LogWarning(const char *fmt, ...)
 #else
     va_list args;
     va_start ( args, fmt );
+    flockfile(stdout);
     printf("[Warning] ");
     vprintf( fmt, args );
     printf("\n");
+    funlockfile(stdout);
     va_end ( args );
 #endif
 }
@@ -408,6 +719,93 @@ std::string UTF16to8(const wchar_t * in)
     return out;
 }
 
+bool UTF16BufferTo8(const char * data, size_t size, std::string *out)
+{
+    assert( out );
+    
+    const unsigned char *in = reinterpret_cast<const unsigned char*>(data);
+    size_t count = size / 2;
+    size_t i = 0;
+    // offset of the low and high bytes in the code units
+    int lo = 0;
+    int hi = 1;
+    if ((count > 0) && (in[0] == 0xfe) && (in[1] == 0xff)) {
+        lo = 1;
+        hi = 0;
+        i = 1;
+    }
+    else if ((count > 0) && (in[0] == 0xff) && (in[1] == 0xfe)) {
+        i = 1;
+    }
+    
+    out->clear();
+    if (i >= count) return true;
+    
+    // A code unit gives at most three bytes (a surrogate pair gives four for two units),
+    // so we can write directly in the string and shrink it at the end
+    out->resize((count - i) * 3);
+    unsigned char *begin = reinterpret_cast<unsigned char*>(&(*out)[0]);
+    unsigned char *dest = begin;
+    
+    // The mask for testing four code units at once - they are ASCII if the high byte is 0
+    // and the low byte < 0x80. It is loaded as the data so the host byte order does not matter.
+    unsigned char maskBytes[8];
+    for (int j = 0; j < 8; j += 2) {
+        maskBytes[j + lo] = 0x80;
+        maskBytes[j + hi] = 0xff;
+    }
+    uint64_t mask;
+    memcpy(&mask, maskBytes, 8);
+    
+    while (i < count) {
+        // fast path for ASCII text (most of the XML markup)
+        while (i + 4 <= count) {
+            uint64_t word;
+            memcpy(&word, in + 2 * i, 8);
+            if ((word & mask) != 0) break;
+            dest[0] = in[2 * i + lo];
+            dest[1] = in[2 * i + 2 + lo];
+            dest[2] = in[2 * i + 4 + lo];
+            dest[3] = in[2 * i + 6 + lo];
+            dest += 4;
+            i += 4;
+        }
+        if (i >= count) break;
+        
+        unsigned int codepoint = (in[2 * i + hi] << 8) | in[2 * i + lo];
+        i++;
+        if (codepoint <= 0x7f) {
+            *dest++ = static_cast<unsigned char>(codepoint);
+        }
+        else if (codepoint <= 0x7ff) {
+            *dest++ = static_cast<unsigned char>(0xc0 | (codepoint >> 6));
+            *dest++ = static_cast<unsigned char>(0x80 | (codepoint & 0x3f));
+        }
+        else if ((codepoint >= 0xd800) && (codepoint <= 0xdbff)) {
+            if (i >= count) return false;
+            unsigned int trail = (in[2 * i + hi] << 8) | in[2 * i + lo];
+            if ((trail < 0xdc00) || (trail > 0xdfff)) return false;
+            i++;
+            codepoint = 0x10000 + ((codepoint - 0xd800) << 10) + (trail - 0xdc00);
+            *dest++ = static_cast<unsigned char>(0xf0 | (codepoint >> 18));
+            *dest++ = static_cast<unsigned char>(0x80 | ((codepoint >> 12) & 0x3f));
+            *dest++ = static_cast<unsigned char>(0x80 | ((codepoint >> 6) & 0x3f));
+            *dest++ = static_cast<unsigned char>(0x80 | (codepoint & 0x3f));
+        }
+        else if ((codepoint >= 0xdc00) && (codepoint <= 0xdfff)) {
+            return false;
+        }
+        else {
+            *dest++ = static_cast<unsigned char>(0xe0 | (codepoint >> 12));
+            *dest++ = static_cast<unsigned char>(0x80 | ((codepoint >> 6) & 0x3f));
+            *dest++ = static_cast<unsigned char>(0x80 | (codepoint & 0x3f));
+        }
+    }
+    
+    out->resize(dest - begin);
+    return true;
+}
+    
 std::wstring UTF8to16(const char * in)
 {
     std::wstring out;
@@ -0,0 +1,45 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:        bench.h
+// Author:      Laurent Pugin
+// Created:     2016
+// Copyright (c) Authors and others. All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+
+// Helpers for the benchmarks (bench_*.cpp). They are built with the tests but not run by ctest
+// since they only report timings. Each of them generates its own synthetic input.
+
+#ifndef __VRV_BENCH_H__
+#define __VRV_BENCH_H__
+
+#include <stdio.h>
+#include <sys/time.h>
+
+/**
+ * Return the wall clock time in seconds.
+ */
+static double GetSeconds( )
+{
+    struct timeval tv;
+    gettimeofday( &tv, NULL );
+    return (double)tv.tv_sec + (double)tv.tv_usec / 1000000.0;
+}
+
+/**
+ * Print one line of results, the time per item being in microseconds.
+ */
+static void PrintResult( const char *label, int size, int items, double seconds )
+{
+    printf( "%-24s %8d %10d %10.3f s %10.2f us/item\n", label, size, items, seconds,
+        ( items > 0 ) ? seconds * 1000000.0 / items : 0.0 );
+}
+
+/**
+ * Print one line of results for a throughput, the size being in bytes.
+ */
+static void PrintThroughput( const char *label, size_t size, int rounds, double seconds )
+{
+    printf( "%-40s %8.2f MB %10.3f s %10.2f MB/s\n", label, (double)size / 1000000.0, seconds,
+        ( seconds > 0.0 ) ? (double)size * rounds / 1000000.0 / seconds : 0.0 );
+}
+
+#endif
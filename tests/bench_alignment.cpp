@@ -0,0 +1,98 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:        bench_alignment.cpp
+// Author:      Laurent Pugin
+// Created:     2016
+// Copyright (c) Authors and others. All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+
+// Loads and lays out the same number of 64th notes in longer and longer measures and reports the time
+// per note. The number of alignments per measure grows with the length of the measure (see
+// MeasureAligner::GetAlignmentAtTime), so the time per note should stay about the same.
+// Usage: bench_alignment <verovio source directory>
+
+#include <iostream>
+#include <sstream>
+#include <string>
+
+//----------------------------------------------------------------------------
+
+#include "bench.h"
+#include "toolkit.h"
+#include "vrv.h"
+
+using namespace vrv;
+
+#define BENCH_BEATS 1024
+#define BENCH_STAVES 2
+
+/**
+ * Generate BENCH_BEATS quarter beats of 64th notes in measures of the given number of beats.
+ * The second layer is shifted by a 128th rest, so each measure has two alignments per note.
+ * Return the number of notes.
+ */
+static int GenerateMEI( int beats, std::string *data )
+{
+    std::stringstream mei;
+    mei << "<?xml version=\"1.0\"?>\n<mei xmlns=\"http://www.music-encoding.org/ns/mei\" meiversion=\"2013\">";
+    mei << "<meiHead/><music><body><mdiv><score><scoreDef meter.count=\"" << beats << "\" meter.unit=\"4\"><staffGrp>";
+    int s, m, l, n;
+    for (s = 1; s <= BENCH_STAVES; s++) {
+        mei << "<staffDef n=\"" << s << "\" lines=\"5\" clef.shape=\"G\" clef.line=\"2\"/>";
+    }
+    mei << "</staffGrp></scoreDef><section>";
+    const char *pnames = "cdefgab";
+    int notes = 0;
+    for (m = 1; m <= BENCH_BEATS / beats; m++) {
+        mei << "<measure n=\"" << m << "\">";
+        for (s = 1; s <= BENCH_STAVES; s++) {
+            mei << "<staff n=\"" << s << "\">";
+            for (l = 1; l <= 2; l++) {
+                mei << "<layer n=\"" << l << "\">";
+                if ( l == 2 ) mei << "<rest dur=\"128\"/>";
+                for (n = 0; n < beats * 16; n++) {
+                    // the last note of the second layer is shortened for the rest
+                    const char *dur = ( ( l == 2 ) && ( n == beats * 16 - 1 ) ) ? "128" : "64";
+                    mei << "<note dur=\"" << dur << "\" oct=\"" << 3 + l << "\" pname=\"" << pnames[ ( n + s ) % 7 ] << "\"/>";
+                    notes++;
+                }
+                mei << "</layer>";
+            }
+            mei << "</staff>";
+        }
+        mei << "</measure>";
+    }
+    mei << "</section></score></mdiv></body></music></mei>";
+    (*data) = mei.str();
+    return notes;
+}
+
+//----------------------------------------------------------------------------
+// main
+//----------------------------------------------------------------------------
+
+int main( int argc, char **argv )
+{
+    if ( argc < 2 ) {
+        std::cerr << "Usage: bench_alignment <verovio source directory>" << std::endl;
+        return 1;
+    }
+    std::string dir = argv[1];
+    Resources::SetDefaultPath( dir + "/data" );
+    DisableLog();
+    
+    printf( "%-24s %8s %10s\n", "", "beats", "notes" );
+    int beats;
+    for (beats = 4; beats <= 64; beats *= 4) {
+        std::string data;
+        int notes = GenerateMEI( beats, &data );
+        Toolkit toolkit;
+        // the horizontal alignment is done with the first layout - RedoLayout re-uses it
+        double start = GetSeconds();
+        if ( !toolkit.LoadString( data ) ) {
+            std::cerr << "Could not load the generated data" << std::endl;
+            return 1;
+        }
+        PrintResult( "LoadString", beats, notes, GetSeconds() - start );
+    }
+    return 0;
+}
@@ -0,0 +1,92 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:        bench_castoff.cpp
+// Author:      Laurent Pugin
+// Created:     2016
+// Copyright (c) Authors and others. All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+
+// Loads scores of 1k, 10k and 50k measures and reports the time per measure for the loading
+// (with the layout) and for laying out the document again (see Doc::CastOff). The time per
+// measure should stay the same as the score gets longer.
+// Usage: bench_castoff <verovio source directory> [maximum number of measures (default is 50000)]
+
+#include <iostream>
+#include <sstream>
+#include <stdlib.h>
+#include <string>
+
+//----------------------------------------------------------------------------
+
+#include "bench.h"
+#include "toolkit.h"
+#include "vrv.h"
+
+using namespace vrv;
+
+/**
+ * Generate two staves of quarter notes and half notes.
+ */
+static std::string GenerateMEI( int measures )
+{
+    std::stringstream mei;
+    mei << "<?xml version=\"1.0\"?>\n<mei xmlns=\"http://www.music-encoding.org/ns/mei\" meiversion=\"2013\">";
+    mei << "<meiHead/><music><body><mdiv><score><scoreDef meter.count=\"4\" meter.unit=\"4\"><staffGrp>";
+    mei << "<staffDef n=\"1\" lines=\"5\" clef.shape=\"G\" clef.line=\"2\"/>";
+    mei << "<staffDef n=\"2\" lines=\"5\" clef.shape=\"F\" clef.line=\"4\"/>";
+    mei << "</staffGrp></scoreDef><section>";
+    const char *pnames = "cdefgab";
+    int m, n;
+    for (m = 1; m <= measures; m++) {
+        mei << "<measure n=\"" << m << "\">";
+        mei << "<staff n=\"1\"><layer n=\"1\">";
+        for (n = 0; n < 4; n++) {
+            mei << "<note dur=\"4\" oct=\"4\" pname=\"" << pnames[ ( m + n ) % 7 ] << "\"/>";
+        }
+        mei << "</layer></staff><staff n=\"2\"><layer n=\"1\">";
+        for (n = 0; n < 2; n++) {
+            mei << "<note dur=\"2\" oct=\"3\" pname=\"" << pnames[ ( m * 3 + n ) % 7 ] << "\"/>";
+        }
+        mei << "</layer></staff></measure>";
+    }
+    mei << "</section></score></mdiv></body></music></mei>";
+    return mei.str();
+}
+
+//----------------------------------------------------------------------------
+// main
+//----------------------------------------------------------------------------
+
+int main( int argc, char **argv )
+{
+    if ( argc < 2 ) {
+        std::cerr << "Usage: bench_castoff <verovio source directory> [maximum number of measures]" << std::endl;
+        return 1;
+    }
+    std::string dir = argv[1];
+    int maxMeasures = ( argc > 2 ) ? atoi( argv[2] ) : 50000;
+    Resources::SetDefaultPath( dir + "/data" );
+    DisableLog();
+    
+    printf( "%-24s %8s\n", "", "measures" );
+    int sizes[] = { 1000, 10000, 50000 };
+    int i;
+    for (i = 0; i < 3; i++) {
+        int measures = sizes[i];
+        if ( measures > maxMeasures ) break;
+        std::string data = GenerateMEI( measures );
+        Toolkit toolkit;
+        double start = GetSeconds();
+        if ( !toolkit.LoadString( data ) ) {
+            std::cerr << "Could not load the generated data" << std::endl;
+            return 1;
+        }
+        PrintResult( "LoadString", measures, measures, GetSeconds() - start );
+        start = GetSeconds();
+        toolkit.RedoLayout();
+        double seconds = GetSeconds() - start;
+        char label[32];
+        snprintf( label, sizeof(label), "RedoLayout (%d pages)", toolkit.GetPageCount() );
+        PrintResult( label, measures, measures, seconds );
+    }
+    return 0;
+}
@@ -0,0 +1,107 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:        bench_load.cpp
+// Author:      Laurent Pugin
+// Created:     2016
+// Copyright (c) Authors and others. All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+
+// Loads the same document again and again, as a long-running service does, and reports the
+// time per load. Each load resets the document of the previous one (see Doc::Reset and the
+// arena of the document), which is compared with loading into a new toolkit each time.
+// Usage: bench_load <verovio source directory> [number of loads (default is 20)]
+
+#include <iostream>
+#include <sstream>
+#include <stdlib.h>
+#include <string>
+
+//----------------------------------------------------------------------------
+
+#include "bench.h"
+#include "toolkit.h"
+#include "vrv.h"
+
+using namespace vrv;
+
+#define BENCH_MEASURES 200
+#define BENCH_STAVES 4
+
+/**
+ * Generate staves with beamed eighth notes, chords, accidentals and lyrics.
+ */
+static std::string GenerateMEI( )
+{
+    std::stringstream mei;
+    mei << "<?xml version=\"1.0\"?>\n<mei xmlns=\"http://www.music-encoding.org/ns/mei\" meiversion=\"2013\">";
+    mei << "<meiHead/><music><body><mdiv><score><scoreDef meter.count=\"4\" meter.unit=\"4\"><staffGrp>";
+    int s, m, n;
+    for (s = 1; s <= BENCH_STAVES; s++) {
+        mei << "<staffDef n=\"" << s << "\" lines=\"5\" clef.shape=\"G\" clef.line=\"2\"/>";
+    }
+    mei << "</staffGrp></scoreDef><section>";
+    const char *pnames = "cdefgab";
+    for (m = 1; m <= BENCH_MEASURES; m++) {
+        mei << "<measure n=\"" << m << "\">";
+        for (s = 1; s <= BENCH_STAVES; s++) {
+            mei << "<staff n=\"" << s << "\"><layer n=\"1\"><beam>";
+            for (n = 0; n < 4; n++) {
+                mei << "<note dur=\"8\" oct=\"4\" pname=\"" << pnames[ ( m + n + s ) % 7 ] << "\"";
+                if ( ( m + n ) % 5 == 0 ) mei << " accid=\"s\"";
+                mei << "><verse n=\"1\"><syl>la</syl></verse></note>";
+            }
+            mei << "</beam><chord dur=\"4\"><note oct=\"4\" pname=\"c\"/><note oct=\"4\" pname=\"e\"/></chord>";
+            mei << "<note dur=\"4\" oct=\"5\" pname=\"" << pnames[ ( m * s ) % 7 ] << "\"/></layer></staff>";
+        }
+        mei << "</measure>";
+    }
+    mei << "</section></score></mdiv></body></music></mei>";
+    return mei.str();
+}
+
+//----------------------------------------------------------------------------
+// main
+//----------------------------------------------------------------------------
+
+int main( int argc, char **argv )
+{
+    if ( argc < 2 ) {
+        std::cerr << "Usage: bench_load <verovio source directory> [number of loads]" << std::endl;
+        return 1;
+    }
+    std::string dir = argv[1];
+    int loads = ( argc > 2 ) ? atoi( argv[2] ) : 20;
+    Resources::SetDefaultPath( dir + "/data" );
+    DisableLog();
+    
+    std::string data = GenerateMEI();
+    printf( "%-24s %8s %10s\n", "", "measures", "loads" );
+    
+    // One toolkit for all the loads, as a service does
+    Toolkit toolkit;
+    int i;
+    double start = GetSeconds();
+    for (i = 0; i < loads; i++) {
+        if ( !toolkit.LoadString( data ) ) {
+            std::cerr << "Could not load the generated data" << std::endl;
+            return 1;
+        }
+    }
+    PrintResult( "LoadString", BENCH_MEASURES, loads, GetSeconds() - start );
+    
+    // The same without the layout, which is mostly the import and the reset
+    toolkit.SetNoLayout( true );
+    start = GetSeconds();
+    for (i = 0; i < loads; i++) {
+        toolkit.LoadString( data );
+    }
+    PrintResult( "LoadString (no layout)", BENCH_MEASURES, loads, GetSeconds() - start );
+    
+    // A new toolkit for each load (the fonts are loaded once for all the toolkits)
+    start = GetSeconds();
+    for (i = 0; i < loads; i++) {
+        Toolkit newToolkit;
+        newToolkit.LoadString( data );
+    }
+    PrintResult( "LoadString (new toolkit)", BENCH_MEASURES, loads, GetSeconds() - start );
+    return 0;
+}
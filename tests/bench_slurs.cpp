@@ -0,0 +1,108 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:        bench_slurs.cpp
+// Author:      Laurent Pugin
+// Created:     2016
+// Copyright (c) Authors and others. All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+
+// Renders a single page with more and more slurs, ties and lyric connectors and reports the
+// time per spanning element. Each of them resumes its group in the SVG (see
+// SvgDeviceContext::ResumeGraphic), so the time per element should stay the same.
+// Usage: bench_slurs <verovio source directory> [maximum number of measures (default is 4000)]
+
+#include <iostream>
+#include <stdlib.h>
+#include <sstream>
+#include <string>
+
+//----------------------------------------------------------------------------
+
+#include "bench.h"
+#include "toolkit.h"
+#include "vrv.h"
+
+using namespace vrv;
+
+/**
+ * Generate one staff with a slur in each measure, a tie to the next measure and lyrics.
+ * Return the number of spanning elements (slurs, ties and connectors).
+ */
+static int GenerateMEI( int measures, std::string *data )
+{
+    std::stringstream mei;
+    mei << "<?xml version=\"1.0\"?>\n<mei xmlns=\"http://www.music-encoding.org/ns/mei\" meiversion=\"2013\">";
+    mei << "<meiHead/><music><body><mdiv><score><scoreDef><staffGrp>";
+    mei << "<staffDef n=\"1\" lines=\"5\" clef.shape=\"G\" clef.line=\"2\"/>";
+    mei << "</staffGrp></scoreDef><section>";
+    const char *pnames = "cdefgab";
+    int spanning = 0;
+    int m, n;
+    for (m = 1; m <= measures; m++) {
+        mei << "<measure n=\"" << m << "\"><staff n=\"1\"><layer n=\"1\">";
+        for (n = 0; n < 4; n++) {
+            // the last note is tied to the first one of the next measure (same pitch)
+            char pname = pnames[ ( n == 3 ) ? ( m + 1 ) % 7 : ( n == 0 ) ? m % 7 : ( m + n * 3 ) % 7 ];
+            mei << "<note xml:id=\"n-" << m << "-" << n << "\" dur=\"4\" oct=\"4\" pname=\"" << pname << "\"";
+            if ( ( n == 3 ) && ( m < measures ) ) {
+                mei << " tie=\"i\"";
+                spanning++;
+            }
+            else if ( ( n == 0 ) && ( m > 1 ) ) {
+                mei << " tie=\"t\"";
+            }
+            mei << "><verse n=\"1\"><syl wordpos=\"" << ( ( n == 0 ) ? "i" : ( n == 3 ) ? "t" : "m" ) << "\"";
+            if ( n < 3 ) {
+                mei << " con=\"d\"";
+                spanning++;
+            }
+            mei << ">la</syl></verse></note>";
+        }
+        mei << "</layer></staff>";
+        mei << "<slur staff=\"1\" startid=\"#n-" << m << "-0\" endid=\"#n-" << m << "-3\"/>";
+        spanning++;
+        mei << "</measure>";
+    }
+    mei << "</section></score></mdiv></body></music></mei>";
+    (*data) = mei.str();
+    return spanning;
+}
+
+//----------------------------------------------------------------------------
+// main
+//----------------------------------------------------------------------------
+
+int main( int argc, char **argv )
+{
+    if ( argc < 2 ) {
+        std::cerr << "Usage: bench_slurs <verovio source directory> [maximum number of measures]" << std::endl;
+        return 1;
+    }
+    std::string dir = argv[1];
+    int maxMeasures = ( argc > 2 ) ? atoi( argv[2] ) : 4000;
+    Resources::SetDefaultPath( dir + "/data" );
+    DisableLog();
+    
+    printf( "%-24s %8s %10s\n", "", "measures", "spanning" );
+    int measures;
+    for (measures = 250; measures <= maxMeasures; measures *= 2) {
+        std::string data;
+        int spanning = GenerateMEI( measures, &data );
+        // everything on one page
+        Toolkit toolkit;
+        toolkit.SetNoLayout( true );
+        if ( !toolkit.LoadString( data ) ) {
+            std::cerr << "Could not load the generated data" << std::endl;
+            return 1;
+        }
+        // the first rendering also lays out the page, which is not measured
+        toolkit.RenderToSvg( 1 );
+        double start = GetSeconds();
+        std::string svg = toolkit.RenderToSvg( 1 );
+        PrintResult( "RenderToSvg", measures, spanning, GetSeconds() - start );
+        toolkit.SetStreamingSvg( true );
+        start = GetSeconds();
+        svg = toolkit.RenderToSvg( 1 );
+        PrintResult( "RenderToSvg (streaming)", measures, spanning, GetSeconds() - start );
+    }
+    return 0;
+}
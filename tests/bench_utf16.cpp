@@ -0,0 +1,159 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:        bench_utf16.cpp
+// Author:      Laurent Pugin
+// Created:     2016
+// Copyright (c) Authors and others. All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+
+// Converts a UTF-16 document (little- and big-endian) to UTF-8 and reports the throughput of
+// UTF16BufferTo8, of the previous conversion (reading two bytes at a time and utf8::utf16to8
+// with a back_inserter) and of loading the document as UTF-16 and as UTF-8.
+// Usage: bench_utf16 <verovio source directory> [number of measures (default is 2000)]
+
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------
+
+#include "bench.h"
+#include "toolkit.h"
+#include "utf8.h"
+#include "vrv.h"
+
+using namespace vrv;
+
+#define BENCH_ROUNDS 10
+
+/**
+ * Generate one staff with lyrics, some of them not in ASCII (with two and three bytes in UTF-8).
+ */
+static std::string GenerateMEI( int measures )
+{
+    std::stringstream mei;
+    mei << "<?xml version=\"1.0\" encoding=\"UTF-16\"?>\n<mei xmlns=\"http://www.music-encoding.org/ns/mei\" meiversion=\"2013\">";
+    mei << "<meiHead/><music><body><mdiv><score><scoreDef><staffGrp>";
+    mei << "<staffDef n=\"1\" lines=\"5\" clef.shape=\"G\" clef.line=\"2\"/>";
+    mei << "</staffGrp></scoreDef><section>";
+    const char *pnames = "cdefgab";
+    const char *syls[] = { "la", "f\xc3\xa9", "\xc3\xbc" "ber", "\xe4\xb8\xad" };
+    int m, n;
+    for (m = 1; m <= measures; m++) {
+        mei << "<measure n=\"" << m << "\"><staff n=\"1\"><layer n=\"1\">";
+        for (n = 0; n < 4; n++) {
+            mei << "<note dur=\"4\" oct=\"4\" pname=\"" << pnames[ ( m + n ) % 7 ] << "\">";
+            mei << "<verse n=\"1\"><syl>" << syls[ ( m + n ) % 4 ] << "</syl></verse></note>";
+        }
+        mei << "</layer></staff></measure>";
+    }
+    mei << "</section></score></mdiv></body></music></mei>";
+    return mei.str();
+}
+
+/**
+ * Encode the UTF-8 data as UTF-16 with a BOM in the given byte order.
+ */
+static std::string EncodeUTF16( const std::string &utf8, bool bigEndian )
+{
+    std::vector<unsigned short> utf16;
+    utf8::utf8to16( utf8.begin(), utf8.end(), std::back_inserter( utf16 ) );
+    std::string data;
+    data.reserve( utf16.size() * 2 + 2 );
+    data += bigEndian ? "\xfe\xff" : "\xff\xfe";
+    std::vector<unsigned short>::iterator iter;
+    for (iter = utf16.begin(); iter != utf16.end(); ++iter) {
+        char high = (char)( (*iter) >> 8 );
+        char low = (char)( (*iter) & 0xff );
+        data += bigEndian ? high : low;
+        data += bigEndian ? low : high;
+    }
+    return data;
+}
+
+/**
+ * The conversion as it was done before UTF16BufferTo8 (little-endian only).
+ */
+static std::string ConvertPrevious( const std::string &data )
+{
+    std::istringstream fin( data );
+    std::vector<unsigned short> utf16line;
+    utf16line.reserve( data.size() / 2 + 1 );
+    unsigned short buffer;
+    while ( fin.read( (char *)&buffer, sizeof(unsigned short) ) ) {
+        utf16line.push_back( buffer );
+    }
+    std::string utf8line;
+    utf8::utf16to8( utf16line.begin() + 1, utf16line.end(), std::back_inserter( utf8line ) );
+    return utf8line;
+}
+
+//----------------------------------------------------------------------------
+// main
+//----------------------------------------------------------------------------
+
+int main( int argc, char **argv )
+{
+    if ( argc < 2 ) {
+        std::cerr << "Usage: bench_utf16 <verovio source directory> [number of measures]" << std::endl;
+        return 1;
+    }
+    std::string dir = argv[1];
+    int measures = ( argc > 2 ) ? atoi( argv[2] ) : 2000;
+    Resources::SetDefaultPath( dir + "/data" );
+    DisableLog();
+    
+    std::string utf8 = GenerateMEI( measures );
+    std::string utf16le = EncodeUTF16( utf8, false );
+    std::string utf16be = EncodeUTF16( utf8, true );
+    
+    std::string out;
+    int i;
+    double start = GetSeconds();
+    for (i = 0; i < BENCH_ROUNDS; i++) {
+        if ( !UTF16BufferTo8( utf16le.data(), utf16le.size(), &out ) || ( out != utf8 ) ) {
+            std::cerr << "The little-endian data is not converted back" << std::endl;
+            return 1;
+        }
+    }
+    PrintThroughput( "UTF16BufferTo8 (little-endian)", utf16le.size(), BENCH_ROUNDS, GetSeconds() - start );
+    
+    start = GetSeconds();
+    for (i = 0; i < BENCH_ROUNDS; i++) {
+        if ( !UTF16BufferTo8( utf16be.data(), utf16be.size(), &out ) || ( out != utf8 ) ) {
+            std::cerr << "The big-endian data is not converted back" << std::endl;
+            return 1;
+        }
+    }
+    PrintThroughput( "UTF16BufferTo8 (big-endian)", utf16be.size(), BENCH_ROUNDS, GetSeconds() - start );
+    
+    start = GetSeconds();
+    for (i = 0; i < BENCH_ROUNDS; i++) {
+        out = ConvertPrevious( utf16le );
+    }
+    PrintThroughput( "previous conversion (little-endian)", utf16le.size(), BENCH_ROUNDS, GetSeconds() - start );
+    
+    // The loading without the layout, where the conversion is the only difference
+    Toolkit toolkit;
+    toolkit.SetNoLayout( true );
+    start = GetSeconds();
+    for (i = 0; i < BENCH_ROUNDS; i++) {
+        if ( !toolkit.LoadString( utf16le ) ) {
+            std::cerr << "Could not load the UTF-16 data" << std::endl;
+            return 1;
+        }
+    }
+    PrintThroughput( "LoadString (UTF-16, no layout)", utf16le.size(), BENCH_ROUNDS, GetSeconds() - start );
+    
+    start = GetSeconds();
+    for (i = 0; i < BENCH_ROUNDS; i++) {
+        if ( !toolkit.LoadString( utf8 ) ) {
+            std::cerr << "Could not load the UTF-8 data" << std::endl;
+            return 1;
+        }
+    }
+    PrintThroughput( "LoadString (UTF-8, no layout)", utf8.size(), BENCH_ROUNDS, GetSeconds() - start );
+    return 0;
+}
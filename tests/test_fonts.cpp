@@ -0,0 +1,144 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:        test_fonts.cpp
+// Author:      Laurent Pugin
+// Created:     2016
+// Copyright (c) Authors and others. All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+
+// Renders documents with different fonts concurrently with several toolkits
+// and checks that the output is the same as when rendered one after the other.
+// Usage: test_fonts <verovio source directory>
+
+#include <ctype.h>
+#include <iostream>
+#include <pthread.h>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------
+
+#include "toolkit.h"
+#include "vrv.h"
+
+using namespace vrv;
+
+#define TEST_THREADS 6
+#define TEST_ROUNDS 20
+
+//----------------------------------------------------------------------------
+// FontJob
+//----------------------------------------------------------------------------
+
+struct FontJob {
+    std::string m_filename;
+    std::string m_format;
+    std::string m_font;
+    std::string m_expected;
+    bool m_ok;
+};
+
+/**
+ * Remove the generated uuids (e.g. note-0000001234567890) since they differ at each rendering.
+ */
+static std::string StripUuids( const std::string &svg )
+{
+    std::string stripped;
+    stripped.reserve( svg.size() );
+    std::string::size_type i = 0;
+    while ( i < svg.size() ) {
+        std::string::size_type j = i;
+        while ( (j < svg.size()) && isdigit( svg[j] ) ) j++;
+        if ( j - i >= 15 ) {
+            stripped += "ID";
+            i = j;
+        }
+        else if ( j > i ) {
+            stripped.append( svg, i, j - i );
+            i = j;
+        }
+        else {
+            stripped += svg[i++];
+        }
+    }
+    return stripped;
+}
+
+static std::string Render( const FontJob &job )
+{
+    Toolkit toolkit;
+    if ( !toolkit.SetFormat( job.m_format ) || !toolkit.SetFont( job.m_font ) || !toolkit.LoadFile( job.m_filename ) ) {
+        return "";
+    }
+    std::string svg;
+    int page;
+    for ( page = 1; page <= toolkit.GetPageCount(); page++ ) {
+        svg += toolkit.RenderToSvg( page );
+    }
+    return StripUuids( svg );
+}
+
+static void *RenderWorker( void *arg )
+{
+    FontJob *job = static_cast<FontJob*>( arg );
+    int i;
+    for ( i = 0; i < TEST_ROUNDS; i++ ) {
+        if ( Render( *job ) != job->m_expected ) {
+            job->m_ok = false;
+        }
+    }
+    return NULL;
+}
+
+//----------------------------------------------------------------------------
+// main
+//----------------------------------------------------------------------------
+
+int main( int argc, char **argv )
+{
+    if ( argc < 2 ) {
+        std::cerr << "Usage: test_fonts <verovio source directory>" << std::endl;
+        return 1;
+    }
+    std::string dir = argv[1];
+    Resources::SetDefaultPath( dir + "/data" );
+    DisableLog();
+
+    const char *files[][2] = {
+        { "/doc/importer.mei", "mei" },
+        { "/doc/tests/mei/01_mensural/01_durations.mei", "mei" },
+        { "/doc/tests/pae/1_clefs/01_G2-clef.pae", "pae" }
+    };
+    const char *fonts[] = { "Leipzig", "Bravura", "Gootville" };
+
+    // The expected output is rendered serially
+    std::vector<FontJob> jobs( TEST_THREADS );
+    int i;
+    for ( i = 0; i < TEST_THREADS; i++ ) {
+        jobs[i].m_filename = dir + files[i % 3][0];
+        jobs[i].m_format = files[i % 3][1];
+        jobs[i].m_font = fonts[(i / 3 + i) % 3];
+        jobs[i].m_expected = Render( jobs[i] );
+        jobs[i].m_ok = !jobs[i].m_expected.empty();
+        if ( !jobs[i].m_ok ) {
+            std::cerr << "Could not render " << jobs[i].m_filename << " with " << jobs[i].m_font << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<pthread_t> workers( TEST_THREADS );
+    for ( i = 0; i < TEST_THREADS; i++ ) {
+        if ( pthread_create( &workers[i], NULL, RenderWorker, &jobs[i] ) != 0 ) {
+            std::cerr << "Could not create the threads" << std::endl;
+            return 1;
+        }
+    }
+    int failures = 0;
+    for ( i = 0; i < TEST_THREADS; i++ ) {
+        pthread_join( workers[i], NULL );
+        if ( !jobs[i].m_ok ) {
+            std::cerr << jobs[i].m_filename << " with " << jobs[i].m_font << " differs when rendered concurrently" << std::endl;
+            failures++;
+        }
+    }
+    return ( failures == 0 ) ? 0 : 1;
+}
@@ -0,0 +1,174 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:        test_prepare.cpp
+// Author:      Laurent Pugin
+// Created:     2016
+// Copyright (c) Authors and others. All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+
+// Prepares the drawing of a document with several staves serially and with threads
+// (see Doc::SetPrepareDrawingThreads) and checks that the pointers set and the uuids of the
+// objects created are the same.
+// Usage: test_prepare
+
+#include <iostream>
+#include <sstream>
+#include <string>
+
+//----------------------------------------------------------------------------
+
+#include "doc.h"
+#include "iomei.h"
+#include "note.h"
+#include "rpt.h"
+#include "syl.h"
+#include "tie.h"
+#include "vrv.h"
+
+using namespace vrv;
+
+#define TEST_STAVES 6
+#define TEST_MEASURES 24
+
+/**
+ * Generate a document with ties, accidentals, lyrics and mRpt in each staff.
+ */
+static std::string GenerateMEI( )
+{
+    std::stringstream mei;
+    mei << "<?xml version=\"1.0\"?>\n<mei xmlns=\"http://www.music-encoding.org/ns/mei\" meiversion=\"2013\">";
+    mei << "<meiHead/><music><body><mdiv><score><section><scoreDef><staffGrp>";
+    int s, m, l, n;
+    for (s = 1; s <= TEST_STAVES; s++) {
+        mei << "<staffDef n=\"" << s << "\" lines=\"5\" clef.shape=\"G\" clef.line=\"2\"/>";
+    }
+    mei << "</staffGrp></scoreDef>";
+    const char *pnames = "cdefgab";
+    const char *wordpos[] = { "i", "m", "m", "t" };
+    for (m = 1; m <= TEST_MEASURES; m++) {
+        mei << "<measure n=\"" << m << "\">";
+        for (s = 1; s <= TEST_STAVES; s++) {
+            mei << "<staff n=\"" << s << "\">";
+            for (l = 1; l <= 2; l++) {
+                mei << "<layer n=\"" << l << "\">";
+                // consecutive mRpt in the second layer
+                if ( ( l == 2 ) && ( ( m + s ) % 6 < 2 ) && ( m > 1 ) ) {
+                    mei << "<mRpt xml:id=\"mrpt-" << m << "-" << s << "\"/></layer>";
+                    continue;
+                }
+                for (n = 0; n < 4; n++) {
+                    std::string id = StringFormat( "note-%d-%d-%d-%d", m, s, l, n );
+                    // the last note of the measure is tied to the first one of the next measure (same pitch)
+                    char pname = pnames[ ( n == 0 ) ? ( m + s + 5 ) % 7 : ( n == 3 ) ? ( m + s + 6 ) % 7 : ( m * n + s ) % 7 ];
+                    mei << "<note xml:id=\"" << id << "\" dur=\"4\" oct=\"" << 3 + l << "\" pname=\"" << pname << "\"";
+                    if ( ( n == 0 ) && ( m > 1 ) && ( ( m + s ) % 3 != 0 ) ) {
+                        mei << " tie=\"t\"";
+                    }
+                    else if ( ( n == 3 ) && ( m < TEST_MEASURES ) && ( ( m + s + 1 ) % 3 != 0 ) ) {
+                        mei << " tie=\"i\"";
+                    }
+                    // an unmatched tie for the warnings
+                    else if ( ( n == 1 ) && ( m % 5 == 0 ) ) {
+                        mei << " tie=\"t\"";
+                    }
+                    if ( ( m + n + s ) % 4 == 0 ) {
+                        mei << " accid=\"s\"";
+                    }
+                    mei << ">";
+                    if ( l == 1 ) {
+                        mei << "<verse n=\"1\"><syl xml:id=\"syl-" << id << "\" wordpos=\"" << wordpos[n] << "\"";
+                        if ( n < 3 ) {
+                            mei << " con=\"d\"";
+                        }
+                        mei << ">la</syl></verse>";
+                    }
+                    mei << "</note>";
+                }
+                mei << "</layer>";
+            }
+            mei << "</staff>";
+        }
+        mei << "</measure>";
+    }
+    mei << "</section></score></mdiv></body></music></mei>";
+    return mei.str();
+}
+
+/**
+ * Describe the pointers set by Doc::PrepareDrawing for the objects of the tree, with the uuids of the
+ * ties and of the accidentals it creates.
+ */
+static void Describe( Object *object, std::stringstream &desc )
+{
+    Note *note = dynamic_cast<Note*>( object );
+    if ( note ) {
+        desc << note->GetUuid();
+        if ( note->GetDrawingTieAttr() && note->GetDrawingTieAttr()->GetEnd() ) {
+            desc << " tie " << note->GetDrawingTieAttr()->GetUuid() << " " << note->GetDrawingTieAttr()->GetEnd()->GetUuid();
+        }
+        if ( note->m_drawingAccid ) {
+            desc << " accid " << note->m_drawingAccid->GetUuid() << " " << note->m_drawingAccid->GetAccid();
+        }
+        desc << std::endl;
+    }
+    Syl *syl = dynamic_cast<Syl*>( object );
+    if ( syl ) {
+        desc << syl->GetUuid() << " " << ( syl->GetStart() ? syl->GetStart()->GetUuid() : "-" );
+        desc << " " << ( syl->GetEnd() ? syl->GetEnd()->GetUuid() : "-" ) << std::endl;
+    }
+    MRpt *mRpt = dynamic_cast<MRpt*>( object );
+    if ( mRpt ) {
+        desc << mRpt->GetUuid() << " " << mRpt->m_drawingMeasureCount << std::endl;
+    }
+    ArrayOfObjects::iterator iter;
+    for (iter = object->m_children.begin(); iter != object->m_children.end(); ++iter) {
+        Describe( *iter, desc );
+    }
+}
+
+static std::string Prepare( const std::string &data, int threads )
+{
+    Doc doc;
+    // the same seed for the uuids to be compared
+    doc.SetUuidSeed( 1 );
+    MeiInput input( &doc, "" );
+    if ( !input.ImportString( data ) ) {
+        return "";
+    }
+    // after the import since it resets the document
+    doc.SetPrepareDrawingThreads( threads );
+    doc.PrepareDrawing();
+    std::stringstream desc;
+    Describe( &doc, desc );
+    return desc.str();
+}
+
+//----------------------------------------------------------------------------
+// main
+//----------------------------------------------------------------------------
+
+int main( int argc, char **argv )
+{
+    DisableLog();
+
+    std::string data = GenerateMEI();
+    std::string serial = Prepare( data, 1 );
+    if ( serial.empty() ) {
+        std::cerr << "The document could not be loaded" << std::endl;
+        return 1;
+    }
+    // make sure the pointers compared are set
+    if ( ( serial.find( " tie " ) == std::string::npos ) || ( serial.find( " accid " ) == std::string::npos ) ) {
+        std::cerr << "The ties and the accidentals were not prepared" << std::endl;
+        return 1;
+    }
+
+    int failures = 0;
+    int threads;
+    for (threads = 2; threads <= TEST_STAVES + 1; threads++) {
+        if ( Prepare( data, threads ) != serial ) {
+            std::cerr << "The drawing prepared with " << threads << " threads differs from the serial one" << std::endl;
+            failures++;
+        }
+    }
+    return ( failures == 0 ) ? 0 : 1;
+}
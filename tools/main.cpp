@@ -6,17 +6,28 @@
 /////////////////////////////////////////////////////////////////////////////
 
 
+#include <algorithm>
 #include <assert.h>
+#include <cerrno>
+#include <cstdio>
 #include <cstdlib>
 #include <ctime>
+#include <fstream>
 #include <getopt.h>
 #include <iostream>
+#include <iterator>
+#include <signal.h>
 #include <sstream>
 #include <string>
+#include <string.h>
+#include <sys/socket.h>
 #include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
 
 //----------------------------------------------------------------------------
 
+#include "jsonxx.h"
 #include "style.h"
 #include "toolkit.h"
 #include "vrv.h"
@@ -62,6 +73,15 @@ bool dir_exists (string dir) {
     }
 }
 
+bool write_file (string filename, string const& data) {
+    ofstream out(filename.c_str());
+    if (!out.is_open()) {
+        return false;
+    }
+    out << data;
+    return true;
+}
+
 void display_version() {
     cerr << "Verovio " << GetVersion() << endl;
 }
@@ -91,7 +111,7 @@ void display_usage() {
     
     cerr << " -o, --outfile=FILE_NAME    Output file name (use \"-\" for standard output)" << endl;
     
-    cerr << " -r, --resources=PATH       Path to SVG resources (default is " <<  vrv::Resources::GetPath() << ")" << endl;
+    cerr << " -r, --resources=PATH       Path to SVG resources (default is " <<  vrv::Resources::GetDefaultPath() << ")" << endl;
     
     cerr << " -s, --scale=FACTOR         Scale percent (default is " << DEFAULT_SCALE << ")" << endl;
     
@@ -108,6 +128,17 @@ void display_usage() {
     
     cerr << " --all-pages                Output all pages with one output file per page" << endl;
     
+    cerr << " --batch                    Read jobs as JSON lines from the standard input and write one JSON result line per job" << endl;
+    cerr << "                            (no input file is expected; the other options are the defaults of the jobs)" << endl;
+    
+    cerr << " --batch-socket=PATH        Read the batch jobs from the connections to the Unix socket PATH" << endl;
+    cerr << "                            and write the results back to them" << endl;
+    
+    cerr << " --batch-socket-mode=MODE   Set the permissions of the batch socket to the octal MODE (default is 600)" << endl;
+    
+    cerr << " --create-font-bundle=FONT  Compile the font of the resource directory into a binary bundle" << endl;
+    cerr << "                            written to the output file (e.g., Leipzig.vrvfont)" << endl;
+    
     cerr << " --even-note-spacing        Space notes evenly and close together regardless of their durations" << endl;
 
     cerr << " --font=FONT                Select the music font to use (default is Leipzig; Bravura and Gootville are also available)" << endl;
@@ -132,6 +163,12 @@ void display_usage() {
     cerr << " --spacing-staff=SP         Specify the spacing above each staff (in MEI vu)," << endl;
     
     cerr << " --spacing-system=SP        Specify the spacing above each system (in MEI vu)," << endl;
+    
+    cerr << " --streaming-svg            Write the SVG directly as text instead of building a DOM (faster, less memory)" << endl;
+    
+    cerr << " --threads=N                Prepare the staves with N threads (default is 1)" << endl;
+    
+    cerr << " --uuid-seed=N              Seed the ids of the elements without xml:id for reproducible output (default is random)" << endl;
 
     // Debugging options
     cerr << endl << "Debugging options" << endl;
@@ -139,6 +176,321 @@ void display_usage() {
     cerr << " --no-justification         Do not justify the system" << endl;
     
     cerr << " --show-bounding-boxes      Show symbol bounding boxes" << endl;
+    
+    // Batch jobs
+    cerr << endl << "Batch jobs" << endl;
+    
+    cerr << " One JSON object per line, for example:" << endl;
+    cerr << " {\"id\": 1, \"input\": \"file.mei\", \"output\": \"file.svg\", \"allPages\": 1}" << endl;
+    cerr << " {\"id\": 2, \"data\": \"@clef:G-2\\n@data:'4C\", \"format\": \"pae\", \"options\": {\"scale\": 50}}" << endl;
+    cerr << " Keys: id (returned with the result), input (file) or data (inline), format, type (svg or mei)," << endl;
+    cerr << " page, allPages, output (file name; the result is returned inline without it) and options" << endl;
+    cerr << " (border, scale, pageHeight, pageWidth, spacingLinear, spacingNonLinear, spacingStaff, spacingSystem," << endl;
+    cerr << " rdgXPathQuery, adjustPageHeight, evenNoteSpacing, ignoreLayout, noLayout, noJustification," << endl;
+    cerr << " progressiveLayout, showBoundingBoxes, streamingSvg, threads, uuidSeed)" << endl;
+}
+
+//----------------------------------------------------------------------------
+// Batch mode
+//----------------------------------------------------------------------------
+
+/**
+ * The default values of the batch jobs given on the command line.
+ */
+struct BatchDefaults
+{
+    Toolkit *m_toolkit;
+    string m_outformat;
+    int m_page;
+    bool m_allPages;
+};
+
+string json_string( string const& str ) {
+    string escaped = "\"";
+    escaped.reserve( str.size() + 2 );
+    string::const_iterator iter;
+    for (iter = str.begin(); iter != str.end(); iter++) {
+        unsigned char ch = (unsigned char)(*iter);
+        if (ch == '"') escaped += "\\\"";
+        else if (ch == '\\') escaped += "\\\\";
+        else if (ch == '\n') escaped += "\\n";
+        else if (ch == '\r') escaped += "\\r";
+        else if (ch == '\t') escaped += "\\t";
+        else if (ch < 0x20) escaped += StringFormat( "\\u%04x", ch );
+        else escaped += (*iter);
+    }
+    escaped += "\"";
+    return escaped;
+}
+
+double elapsed_ms( const struct timeval &start ) {
+    struct timeval end;
+    gettimeofday( &end, NULL );
+    return (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_usec - start.tv_usec) / 1000.0;
+}
+
+// Read a flag given as a number or as a boolean
+bool get_json_flag( jsonxx::Object &json, const char *key, bool *value ) {
+    if (json.has<jsonxx::Number>(key)) {
+        (*value) = (json.get<jsonxx::Number>(key) != 0);
+        return true;
+    }
+    if (json.has<jsonxx::Boolean>(key)) {
+        (*value) = json.get<jsonxx::Boolean>(key);
+        return true;
+    }
+    return false;
+}
+
+// Set the options of a job - the names are the ones of Toolkit::ParseOptions
+bool set_job_options( Toolkit &toolkit, jsonxx::Object &options, string *error ) {
+    bool ok = true;
+    bool flag;
+    
+    if (options.has<jsonxx::Number>("border"))
+        ok = ok && toolkit.SetBorder( options.get<jsonxx::Number>("border") );
+    if (options.has<jsonxx::Number>("scale"))
+        ok = ok && toolkit.SetScale( options.get<jsonxx::Number>("scale") );
+    if (options.has<jsonxx::Number>("pageHeight"))
+        ok = ok && toolkit.SetPageHeight( options.get<jsonxx::Number>("pageHeight") );
+    if (options.has<jsonxx::Number>("pageWidth"))
+        ok = ok && toolkit.SetPageWidth( options.get<jsonxx::Number>("pageWidth") );
+    if (options.has<jsonxx::Number>("spacingLinear"))
+        ok = ok && toolkit.SetSpacingLinear( options.get<jsonxx::Number>("spacingLinear") );
+    if (options.has<jsonxx::Number>("spacingNonLinear"))
+        ok = ok && toolkit.SetSpacingNonLinear( options.get<jsonxx::Number>("spacingNonLinear") );
+    if (options.has<jsonxx::Number>("spacingStaff"))
+        ok = ok && toolkit.SetSpacingStaff( options.get<jsonxx::Number>("spacingStaff") );
+    if (options.has<jsonxx::Number>("spacingSystem"))
+        ok = ok && toolkit.SetSpacingSystem( options.get<jsonxx::Number>("spacingSystem") );
+    if (options.has<jsonxx::Number>("threads"))
+        ok = ok && toolkit.SetThreads( options.get<jsonxx::Number>("threads") );
+    if (options.has<jsonxx::Number>("uuidSeed"))
+        ok = ok && toolkit.SetUuidSeed( options.get<jsonxx::Number>("uuidSeed") );
+    if (options.has<jsonxx::String>("rdgXPathQuery"))
+        toolkit.SetRdgXPathQuery( options.get<jsonxx::String>("rdgXPathQuery") );
+    
+    if (get_json_flag( options, "adjustPageHeight", &flag )) toolkit.SetAdjustPageHeight( flag );
+    if (get_json_flag( options, "evenNoteSpacing", &flag )) toolkit.SetEvenNoteSpacing( flag );
+    if (get_json_flag( options, "ignoreLayout", &flag )) toolkit.SetIgnoreLayout( flag );
+    if (get_json_flag( options, "noLayout", &flag )) toolkit.SetNoLayout( flag );
+    if (get_json_flag( options, "noJustification", &flag )) toolkit.SetNoJustification( flag );
+    if (get_json_flag( options, "progressiveLayout", &flag )) toolkit.SetProgressiveLayout( flag );
+    if (get_json_flag( options, "showBoundingBoxes", &flag )) toolkit.SetShowBoundingBoxes( flag );
+    if (get_json_flag( options, "streamingSvg", &flag )) toolkit.SetStreamingSvg( flag );
+    
+    if (!ok) {
+        (*error) = "Invalid option value";
+    }
+    return ok;
+}
+
+// Run one job with the toolkit and return the result (without the id)
+string run_job( Toolkit &toolkit, BatchDefaults &defaults, jsonxx::Object &job, string *error ) {
+    struct timeval start;
+    gettimeofday( &start, NULL );
+    
+    // reset the options of the previous job
+    toolkit.CopyOptions( defaults.m_toolkit );
+    
+    if (job.has<jsonxx::String>("format") && !toolkit.SetFormat( job.get<jsonxx::String>("format") )) {
+        (*error) = "Invalid input format";
+        return "";
+    }
+    if (job.has<jsonxx::Object>("options") && !set_job_options( toolkit, job.get<jsonxx::Object>("options"), error )) {
+        return "";
+    }
+    string outformat = defaults.m_outformat;
+    if (job.has<jsonxx::String>("type")) {
+        outformat = job.get<jsonxx::String>("type");
+    }
+    if (outformat != "svg" && outformat != "mei") {
+        (*error) = "Output format can only be 'mei' or 'svg'";
+        return "";
+    }
+    int page = defaults.m_page;
+    if (job.has<jsonxx::Number>("page")) {
+        page = (int)job.get<jsonxx::Number>("page");
+    }
+    bool all_pages = defaults.m_allPages;
+    get_json_flag( job, "allPages", &all_pages );
+    string outfile;
+    if (job.has<jsonxx::String>("output")) {
+        outfile = removeExtension( job.get<jsonxx::String>("output") );
+    }
+    
+    // Load the file or the inline data
+    if (job.has<jsonxx::String>("input")) {
+        if (!toolkit.LoadFile( job.get<jsonxx::String>("input") )) {
+            (*error) = "The file '" + job.get<jsonxx::String>("input") + "' could not be loaded";
+            return "";
+        }
+    }
+    else if (job.has<jsonxx::String>("data")) {
+        if (!toolkit.LoadString( job.get<jsonxx::String>("data") )) {
+            (*error) = "The data could not be loaded";
+            return "";
+        }
+    }
+    else {
+        (*error) = "An input file or data is required";
+        return "";
+    }
+    double load_time = elapsed_ms( start );
+    
+    // The page count is only an estimate until the pages are cast off (see progressiveLayout)
+    toolkit.ContinueLayout( all_pages ? 0 : std::max( page, 1 ) );
+    if ((page < 1) || (page > toolkit.GetPageCount())) {
+        (*error) = StringFormat( "The page requested (%d) is not in the page range (max is %d)", page, toolkit.GetPageCount() );
+        return "";
+    }
+    int from = page;
+    int to = all_pages ? toolkit.GetPageCount() + 1 : page + 1;
+    
+    string result;
+    if (outformat == "svg") {
+        result = outfile.empty() ? "\"svg\": [" : "\"output\": [";
+        int p;
+        for (p = from; p < to; p++) {
+            if (p > from) result += ", ";
+            if (outfile.empty()) {
+                result += json_string( toolkit.RenderToSvg( p ) );
+                continue;
+            }
+            string cur_outfile = outfile;
+            if (all_pages) {
+                cur_outfile += StringFormat("_%03d", p);
+            }
+            cur_outfile += ".svg";
+            if ( !toolkit.RenderToSvgFile( cur_outfile, p ) ) {
+                (*error) = "Unable to write SVG to " + cur_outfile;
+                return "";
+            }
+            result += json_string( cur_outfile );
+        }
+        result += "]";
+    }
+    else {
+        string mei = all_pages ? toolkit.GetMEI( 0, true ) : toolkit.GetMEI( page );
+        if (outfile.empty()) {
+            result = "\"mei\": " + json_string( mei );
+        }
+        else if (!write_file( outfile + ".mei", mei )) {
+            (*error) = "Unable to write MEI to " + outfile + ".mei";
+            return "";
+        }
+        else {
+            result = "\"output\": [" + json_string( outfile + ".mei" ) + "]";
+        }
+    }
+    
+    double total_time = elapsed_ms( start );
+    return StringFormat( "\"pageCount\": %d, \"loadTime\": %.3f, \"renderTime\": %.3f, ",
+        toolkit.GetPageCount(), load_time, total_time - load_time ) + result;
+}
+
+// Read the jobs line by line and write one result line for each of them
+void run_batch( FILE *in, FILE *out, Toolkit &toolkit, BatchDefaults &defaults ) {
+    char *line = NULL;
+    size_t capacity = 0;
+    ssize_t length;
+    while ((length = getline( &line, &capacity, in )) != -1) {
+        string json( line, length );
+        // skip empty lines
+        if (json.find_first_not_of( " \t\r\n" ) == string::npos) {
+            continue;
+        }
+        
+        jsonxx::Object job;
+        string id = "null";
+        string error;
+        string result;
+        if (!job.parse( json )) {
+            error = "The job is not a valid JSON object";
+        }
+        else {
+            if (job.has<jsonxx::String>("id")) {
+                id = json_string( job.get<jsonxx::String>("id") );
+            }
+            else if (job.has<jsonxx::Number>("id")) {
+                id = StringFormat( "%.15g", (double)job.get<jsonxx::Number>("id") );
+            }
+            result = run_job( toolkit, defaults, job, &error );
+        }
+        
+        if (!error.empty()) {
+            fprintf( out, "{\"id\": %s, \"status\": \"error\", \"message\": %s}\n", id.c_str(), json_string( error ).c_str() );
+        }
+        else {
+            fprintf( out, "{\"id\": %s, \"status\": \"ok\", %s}\n", id.c_str(), result.c_str() );
+        }
+        fflush( out );
+    }
+    free( line );
+}
+
+// The number of accept failures in a row after which the batch socket is closed
+// The server waits one more second after each of them
+#define BATCH_SOCKET_MAX_FAILURES 10
+
+// Accept the connections on a Unix socket one after the other and run their jobs
+int run_batch_socket( string const& path, mode_t mode, Toolkit &toolkit, BatchDefaults &defaults ) {
+    struct sockaddr_un address;
+    if (path.size() >= sizeof(address.sun_path)) {
+        cerr << "The socket path '" << path << "' is too long." << endl;
+        return 1;
+    }
+    int server = socket( AF_UNIX, SOCK_STREAM, 0 );
+    if (server == -1) {
+        cerr << "The socket could not be created." << endl;
+        return 1;
+    }
+    memset( &address, 0, sizeof(address) );
+    address.sun_family = AF_UNIX;
+    strncpy( address.sun_path, path.c_str(), sizeof(address.sun_path) - 1 );
+    unlink( path.c_str() );
+    // nobody else can connect before the permissions are set
+    mode_t previous_umask = umask( 0077 );
+    int bound = bind( server, (struct sockaddr*)&address, sizeof(address) );
+    umask( previous_umask );
+    if ((bound == -1) || (chmod( path.c_str(), mode ) == -1) || (listen( server, 16 ) == -1)) {
+        cerr << "The socket '" << path << "' could not be opened." << endl;
+        close( server );
+        return 1;
+    }
+    // do not stop when a client disconnects before reading its results
+    signal( SIGPIPE, SIG_IGN );
+    cerr << "Waiting for batch jobs on " << path << "." << endl;
+    
+    int failures = 0;
+    while (true) {
+        int connection = accept( server, NULL, NULL );
+        if (connection == -1) {
+            // the connection was interrupted or aborted by the client
+            if ((errno == EINTR) || (errno == ECONNABORTED)) {
+                continue;
+            }
+            // e.g., no file descriptor left - wait for the situation to change but give up if it persists
+            if (++failures >= BATCH_SOCKET_MAX_FAILURES) {
+                cerr << "The connections to the socket '" << path << "' could not be accepted (" << strerror( errno ) << ")." << endl;
+                close( server );
+                unlink( path.c_str() );
+                return 1;
+            }
+            sleep( failures );
+            continue;
+        }
+        failures = 0;
+        FILE *in = fdopen( connection, "r" );
+        FILE *out = fdopen( dup( connection ), "w" );
+        if (in && out) {
+            run_batch( in, out, toolkit, defaults );
+        }
+        if (in) fclose( in );
+        else close( connection );
+        if (out) fclose( out );
+    }
+    return 0;
 }
 
 
@@ -150,10 +502,14 @@ int main(int argc, char** argv)
     string outfile;
     string outformat = "svg";
     string font = "";
+    string font_bundle = "";
+    string batch_socket = "";
+    mode_t batch_socket_mode = 0600;
     bool std_output = false;
     
     // Init random number generator for uuids
     std::srand((unsigned int)std::time(0));
+    Object::SeedUuidGenerator( (unsigned int)std::rand() );
     
     FileFormat type;
     int no_mei_hdr = 0;
@@ -164,13 +520,16 @@ int main(int argc, char** argv)
     int no_justification = 0;
     int even_note_spacing = 0;
     int show_bounding_boxes = 0;
+    int streaming_svg = 0;
+    int batch = 0;
     int page = 1;
+    int threads = 1;
     int show_help = 0;
     int show_version = 0;
     
     // Create the toolkit instance without loading the font because
     // the resource path might be specified in the parameters
-    // The fonts will be loaded later with Resources::InitFonts()
+    // The fonts will be loaded later with Toolkit::SetResourcePath()
     Toolkit toolkit( false );
     
     // read pae by default
@@ -188,7 +547,11 @@ int main(int argc, char** argv)
         
         {"adjust-page-height",  no_argument,        &adjust_page_height, 1},
         {"all-pages",           no_argument,        &all_pages, 1},
+        {"batch",               no_argument,        &batch, 1},
+        {"batch-socket",        required_argument,  0, 0},
+        {"batch-socket-mode",   required_argument,  0, 0},
         {"border",              required_argument,  0, 'b'},
+        {"create-font-bundle",  required_argument,  0, 0},
         {"even-note-spacing",   no_argument,        &even_note_spacing, 1},
         {"font",                required_argument,  0, 0},
         {"format",              required_argument,  0, 'f'},
@@ -209,7 +572,10 @@ int main(int argc, char** argv)
         {"spacing-non-linear",  required_argument,  0, 0},
         {"spacing-staff",       required_argument,  0, 0},
         {"spacing-system",      required_argument,  0, 0},
+        {"streaming-svg",       no_argument,        &streaming_svg, 1},
+        {"threads",             required_argument,  0, 0},
         {"type",                required_argument,  0, 't'},
+        {"uuid-seed",           required_argument,  0, 0},
         {"version",             no_argument,        &show_version, 1},
         {0, 0, 0, 0}
     };
@@ -222,7 +588,22 @@ int main(int argc, char** argv)
             case 0:
                 if (long_options[option_index].flag != 0)
                     break;
-                if (strcmp(long_options[option_index].name,"font") == 0) {
+                if (strcmp(long_options[option_index].name,"batch-socket") == 0) {
+                    batch_socket = string(optarg);
+                }
+                else if (strcmp(long_options[option_index].name,"batch-socket-mode") == 0) {
+                    char *end = NULL;
+                    long mode = strtol(optarg, &end, 8);
+                    if ((*end != '\0') || (mode < 0) || (mode > 0777)) {
+                        cerr << "The batch socket mode '" << optarg << "' is not a valid octal mode." << endl;
+                        exit(1);
+                    }
+                    batch_socket_mode = (mode_t)mode;
+                }
+                else if (strcmp(long_options[option_index].name,"create-font-bundle") == 0) {
+                    font_bundle = string(optarg);
+                }
+                else if (strcmp(long_options[option_index].name,"font") == 0) {
                     font = string(optarg);
                 }
                 else if (strcmp(long_options[option_index].name,"page") == 0) {
@@ -252,6 +633,18 @@ int main(int argc, char** argv)
                         exit(1);
                     }
                 }
+                else if (strcmp(long_options[option_index].name,"threads") == 0) {
+                    threads = atoi(optarg);
+                    if (threads < 1) {
+                        cerr << "The number of threads has to be greater than 0." << endl;
+                        exit(1);
+                    }
+                }
+                else if (strcmp(long_options[option_index].name,"uuid-seed") == 0) {
+                    if ( !toolkit.SetUuidSeed( atoi(optarg) ) ) {
+                        exit(1);
+                    }
+                }
                 break;
                 
             case 'b':
@@ -277,7 +670,7 @@ int main(int argc, char** argv)
                 break;
                 
             case 'r':
-                vrv::Resources::SetPath(optarg);
+                vrv::Resources::SetDefaultPath(optarg);
                 break;
                 
             case 't':
@@ -320,6 +713,20 @@ int main(int argc, char** argv)
         exit(0);
     }
     
+    // Compile the font bundle - no input file is expected in this case
+    if (!font_bundle.empty()) {
+        if (outfile.empty()) {
+            cerr << "An output file is required for creating a font bundle." << endl;
+            exit(1);
+        }
+        if (!Resources::CreateFontBundle(Resources::GetDefaultPath(), font_bundle, outfile)) {
+            cerr << "Font bundle for '" << font_bundle << "' could not be created." << endl;
+            exit(1);
+        }
+        cerr << "Output written to " << outfile << "." << endl;
+        exit(0);
+    }
+    
     // Set the various flags
     toolkit.SetAdjustPageHeight(adjust_page_height);
     toolkit.SetNoLayout(no_layout);
@@ -327,11 +734,13 @@ int main(int argc, char** argv)
     toolkit.SetNoJustification(no_justification);
     toolkit.SetEvenNoteSpacing(even_note_spacing);
     toolkit.SetShowBoundingBoxes(show_bounding_boxes);
+    toolkit.SetStreamingSvg(streaming_svg);
+    toolkit.SetThreads(threads);
     
     if (optind <= argc - 1) {
         infile = string(argv[optind]);
     }
-    else {
+    else if (!batch && batch_socket.empty()) {
         cerr << "Incorrect number of arguments: expected one input file but found none." << endl << endl;
         display_usage();
         exit(1);
@@ -339,13 +748,13 @@ int main(int argc, char** argv)
     
     // Make sure the user uses a valid Resource path
     // Save many headaches for empty SVGs
-    if(!dir_exists(vrv::Resources::GetPath())) {
-        cerr << "The resources path " << vrv::Resources::GetPath() << " could not be found; please use -r option." << endl;
+    if(!dir_exists(vrv::Resources::GetDefaultPath())) {
+        cerr << "The resources path " << vrv::Resources::GetDefaultPath() << " could not be found; please use -r option." << endl;
         exit(1);
     }
 
     // Loaded the music font from the resource directory
-    if (!Resources::InitFonts()) {
+    if (!toolkit.SetResourcePath(vrv::Resources::GetDefaultPath())) {
         cerr << "The music font could not be loaded; please check the contents of the resource directory." << endl;
         exit(1);
     }
@@ -361,6 +770,24 @@ int main(int argc, char** argv)
         exit(1);
     }
     
+    // Run the batch jobs with one toolkit re-used for all of them
+    // The toolkit of the command line options gives the default options of the jobs
+    if (batch || !batch_socket.empty()) {
+        BatchDefaults defaults;
+        defaults.m_toolkit = &toolkit;
+        defaults.m_outformat = outformat;
+        defaults.m_page = page;
+        defaults.m_allPages = all_pages;
+        Toolkit job_toolkit( false );
+        if (!batch_socket.empty()) {
+            return run_batch_socket( batch_socket, batch_socket_mode, job_toolkit, defaults );
+        }
+        // the log would be mixed with the results
+        DisableLog();
+        run_batch( stdin, stdout, job_toolkit, defaults );
+        return 0;
+    }
+    
     // Make sure we provide a file name or output to std output with std input
     if ((infile == "-") && (outfile.empty())) {
         cerr << "Standard input can be used only with standard output or output filename." << endl;
@@ -381,11 +808,9 @@ int main(int argc, char** argv)
     
     // Load the std input or load the file
     if ( infile == "-" ) {
-        stringstream data_stream;
-        for (string line; getline(cin, line);) {
-            data_stream << line << endl;
-        }
-        if ( !toolkit.LoadString( data_stream.str() ) ) {
+        // read it at once since it can be UTF-16 (converted by LoadString)
+        string data( (istreambuf_iterator<char>( cin )), istreambuf_iterator<char>() );
+        if ( !toolkit.LoadString( data ) ) {
             cerr << "The input could not be loaded." << endl;
             exit(1);
         }
@@ -397,7 +822,8 @@ int main(int argc, char** argv)
         }
     }
 
-    // Check the page range
+    // Check the page range - the page count is only an estimate until the pages are cast off
+    toolkit.ContinueLayout( all_pages ? 0 : std::max( page, 1 ) );
     if (page > toolkit.GetPageCount()) {
         cerr << "The page requested (" << page << ") is not in the page range (max is " << toolkit.GetPageCount() << ")." << endl;
         exit(1);